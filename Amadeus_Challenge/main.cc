@@ -7,8 +7,18 @@
 #include <string>
 #include <utility>
 #include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <unistd.h>
 using namespace std;
 
+// PlanetMask::count()の__builtin_popcountllを、ライブラリ呼び出しではなくpopcnt命令にする
+#pragma GCC target("popcnt")
+
 const int MAX_PLANET_COUNT = 90;
 const int INF = (1 << 28);
 
@@ -19,7 +29,61 @@ const int UNIT_SPREAD = 1;
 int planetCount;
 int edgeCount;
 
-vector<int> G[MAX_PLANET_COUNT];    // グラフ構造を表す。
+// グラフ構造 (CSR形式)。惑星idの隣接惑星は neighbors[offsets[id]] から neighbors[offsets[id + 1] - 1] まで
+int offsets[MAX_PLANET_COUNT + 1];
+vector<int> neighbors;
+
+struct NeighborRange {
+    const int* first;
+    const int* last;
+
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+};
+
+// for (int neighbor : adjacent(id)) のように使う
+inline NeighborRange adjacent(int id) {
+    return NeighborRange{neighbors.data() + offsets[id], neighbors.data() + offsets[id + 1]};
+}
+
+// 惑星の集合を表す128bitのビットマスク
+struct PlanetMask {
+    uint64_t bits[2] = {0, 0};
+
+    void set(int id) {
+        bits[id >> 6] |= 1ULL << (id & 63);
+    }
+    void reset(int id) {
+        bits[id >> 6] &= ~(1ULL << (id & 63));
+    }
+    bool test(int id) const {
+        return bits[id >> 6] >> (id & 63) & 1;
+    }
+    int count() const {
+        return __builtin_popcountll(bits[0]) + __builtin_popcountll(bits[1]);
+    }
+    PlanetMask operator&(const PlanetMask& mask) const {
+        PlanetMask res;
+        res.bits[0] = bits[0] & mask.bits[0];
+        res.bits[1] = bits[1] & mask.bits[1];
+        return res;
+    }
+    PlanetMask& operator|=(const PlanetMask& mask) {
+        bits[0] |= mask.bits[0];
+        bits[1] |= mask.bits[1];
+        return *this;
+    }
+
+    // 含まれる惑星それぞれについてf(id)を呼ぶ
+    template<class F>
+    void forEach(F f) const {
+        for (int w = 0; w < 2; w++) {
+            for (uint64_t b = bits[w]; b; b &= b - 1) f(64 * w + __builtin_ctzll(b));
+        }
+    }
+};
+
+PlanetMask neighborMask[MAX_PLANET_COUNT];  // 隣接惑星の集合
 
 struct Move {
     int type;           // 0: 通常 1: unit spread
@@ -34,21 +98,146 @@ struct Move {
 
 using Strategy = vector<Move>;
 
+// GameState::applyで変わる前の値。GameState::undoに渡すと元に戻せる
+struct StateUndo {
+    PlanetMask myLead;
+    PlanetMask otherLead;
+    int total;
+    int count;                              // 寄与が変わった惑星の数
+    short planets[MAX_PLANET_COUNT];
+    short contributions[MAX_PLANET_COUNT];  // 変わる前の寄与
+};
+
+// 値はどれも小さいので16bitで持ち、コピーや走査で触るメモリを減らす
 struct GameState {
     int score;
-    array<int, MAX_PLANET_COUNT> myUnits;
-    array<int, MAX_PLANET_COUNT> myTolerance;
-    array<int, MAX_PLANET_COUNT> otherUnits;
-    array<int, MAX_PLANET_COUNT> otherTolerance;
-    array<int, MAX_PLANET_COUNT> canAssign;
+    array<short, MAX_PLANET_COUNT> myUnits;
+    array<short, MAX_PLANET_COUNT> myTolerance;
+    array<short, MAX_PLANET_COUNT> otherUnits;
+    array<short, MAX_PLANET_COUNT> otherTolerance;
+    array<short, MAX_PLANET_COUNT> canAssign;
+
+    // evaluateGameStateの差分計算用。惑星ごとの寄与とその合計を持ち、ユニット数が変わった惑星の周りだけ更新する
+    PlanetMask myLead;      // 自分がリードしている惑星
+    PlanetMask otherLead;   // 相手がリードしている惑星
+    array<short, MAX_PLANET_COUNT> contribution;
+    int total;
 
     GameState() {}
-    GameState(const GameState& state) {
-        myUnits        = state.myUnits;
-        myTolerance    = state.myTolerance;
-        otherUnits     = state.otherUnits;
-        otherTolerance = state.otherTolerance;
-        canAssign      = state.canAssign;
+
+    // unitsにtype・targetの行動を加える (signが-1なら取り除く)。ユニット数が変わった惑星を返す
+    static PlanetMask moveUnits(array<short, MAX_PLANET_COUNT>& units, int type, int target, int sign) {
+        PlanetMask changed;
+        if (type == NORMAL) {
+            units[target] += sign;
+            changed.set(target);
+        } else if (target >= 0) {   // UNIT SPREAD
+            units[target] -= 5 * sign;
+            for (int neighbor : adjacent(target)) {
+                units[neighbor] += sign;
+            }
+            changed.set(target);
+            changed |= neighborMask[target];
+        }
+        return changed;
+    }
+
+    // 自分の行動をその場で適用する。undoを渡すと元に戻すための値を記録する
+    void apply(int type, int target, StateUndo* undo = nullptr) {
+        updateEvaluation(moveUnits(myUnits, type, target, 1), undo);
+    }
+    void apply(const Move& move, StateUndo* undo = nullptr) {
+        apply(move.type, move.target, undo);
+    }
+
+    // applyした行動を取り消す
+    void undo(int type, int target, const StateUndo& undo) {
+        moveUnits(myUnits, type, target, -1);
+        restore(undo);
+    }
+    void undo(const Move& move, const StateUndo& undo) {
+        this->undo(move.type, move.target, undo);
+    }
+
+    // 相手の行動をその場で適用する / 取り消す
+    void applyOther(int type, int target, StateUndo* undo = nullptr) {
+        updateEvaluation(moveUnits(otherUnits, type, target, 1), undo);
+    }
+    void undoOther(int type, int target, const StateUndo& undo) {
+        moveUnits(otherUnits, type, target, -1);
+        restore(undo);
+    }
+
+    void restore(const StateUndo& undo) {
+        myLead    = undo.myLead;
+        otherLead = undo.otherLead;
+        total     = undo.total;
+        for (int i = 0; i < undo.count; i++) contribution[undo.planets[i]] = undo.contributions[i];
+    }
+
+    // 惑星idの評価値への寄与。自分がリードしている惑星だけが点になる
+    int computeContribution(int id) const {
+        if (!myLead.test(id)) return 0;
+        int advantage = myUnits[id] - otherUnits[id];
+
+        // 隣接惑星のうち、自分・相手がリードしている数
+        int friendCount = (neighborMask[id] & myLead).count(),
+            enemyCount  = (neighborMask[id] & otherLead).count();
+
+        if (friendCount > enemyCount) advantage++;
+        else if (friendCount < enemyCount) advantage--;
+
+        return 20 * (advantage > 0) - enemyCount;
+    }
+
+    // 惑星idのリードの状態を更新し、変わったらtrueを返す
+    bool updateLead(int id) {
+        bool mine   = myLead.test(id),
+             theirs = otherLead.test(id);
+        int advantage = myUnits[id] - otherUnits[id];
+        if (advantage > 0) myLead.set(id); else myLead.reset(id);
+        if (advantage < 0) otherLead.set(id); else otherLead.reset(id);
+        return mine != (advantage > 0) or theirs != (advantage < 0);
+    }
+
+    // 入力を読んだ直後に、寄与と合計を一から計算する
+    void initEvaluation() {
+        myLead    = PlanetMask();
+        otherLead = PlanetMask();
+        for (int id = 0; id < planetCount; id++) updateLead(id);
+
+        total = 0;
+        for (int id = 0; id < planetCount; id++) {
+            contribution[id] = computeContribution(id);
+            total += contribution[id];
+        }
+    }
+
+    // changedの惑星のユニット数が変わった後に呼ぶ。寄与が変わりうるのは、changed自身と
+    // リードの状態が変わった惑星の隣接惑星だけ
+    void updateEvaluation(const PlanetMask& changed, StateUndo* undo = nullptr) {
+        if (undo != nullptr) {
+            undo->myLead    = myLead;
+            undo->otherLead = otherLead;
+            undo->total     = total;
+            undo->count     = 0;
+        }
+
+        PlanetMask dirty = changed;
+        changed.forEach([&](int id) {
+            if (updateLead(id)) dirty |= neighborMask[id];
+        });
+        dirty.forEach([&](int id) {
+            int c = computeContribution(id);
+            if (c == contribution[id]) return;
+            if (undo != nullptr) {
+                undo->planets[undo->count]       = id;
+                undo->contributions[undo->count] = contribution[id];
+                undo->count++;
+            }
+            total += c - contribution[id];
+            contribution[id] = c;
+        });
     }
     bool operator<(const GameState& state) const {
         return score < state.score;
@@ -58,48 +247,374 @@ struct GameState {
     }
 };
 
-// n未満の自然数をランダムに生成する
+// Timer / Reader / TimeManager / PCG32はCode_of_Kutulu/main.ccからの写し。直すときは向こうを直してから写す
+struct Timer {
+    chrono::steady_clock::time_point start;
+
+    Timer() { reset(); }
+
+    void reset() {
+        start = chrono::steady_clock::now();
+    }
+
+    // 経過時間 [us]
+    long long elapsedMicros() const {
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+// 標準入力をread()でまとめて読み込み、数値と単語を自前で解析する
+struct Reader {
+    static const int BUFFER_SIZE = (1 << 16);
+
+    char buffer[BUFFER_SIZE];
+    int pos = 0;
+    int len = 0;
+    bool eof = false;       // read()がこれ以上データを返さない
+    bool failed = false;    // 入力が尽きた状態で読もうとした
+
+    Timer arrival;          // このターンの入力の最初の1バイトが届いた時刻
+    bool waiting = true;    // 次のターンの入力がまだ届いていない
+
+    // 手元のデータを入力として使う (ベンチマーク用)
+    void load(const char* data, int size) {
+        assert(size <= BUFFER_SIZE);
+        memcpy(buffer, data, size);
+        pos = 0;
+        len = size;
+        eof = true;
+        failed = false;
+        arrival.reset();
+        waiting = false;
+    }
+
+    // 出力を終えたら呼ぶ。次に届いたデータの時刻をそのターンの開始とする
+    void nextTurn() {
+        while (pos < len and buffer[pos] <= ' ') pos++;
+        waiting = (pos == len);
+        if (!waiting) arrival.reset();  // 既に次の入力が届いている
+    }
+
+    bool fill() {
+        if (eof) return false;
+        ssize_t n = read(0, buffer, BUFFER_SIZE);
+        if (n <= 0) {
+            eof = true;
+            return false;
+        }
+        pos = 0;
+        len = n;
+        if (waiting) {
+            arrival.reset();
+            waiting = false;
+        }
+        return true;
+    }
+
+    bool hasChar() {
+        return pos < len or fill();
+    }
+
+    // 空白を読み飛ばす。読める文字がなければfailedを立てる
+    bool skipSpaces() {
+        while (hasChar() and buffer[pos] <= ' ') pos++;
+        if (!hasChar()) {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    int readInt() {
+        if (!skipSpaces()) return 0;
+
+        bool negative = (buffer[pos] == '-');
+        if (negative) pos++;
+
+        int value = 0;
+        while (hasChar() and '0' <= buffer[pos] and buffer[pos] <= '9') {
+            value = value * 10 + (buffer[pos++] - '0');
+        }
+        return negative ? -value : value;
+    }
+
+    // 空白までをtokenに書き込み、長さを返す (capacity - 1文字を超える分は捨てる)
+    int readToken(char* token, int capacity) {
+        int length = 0;
+        if (skipSpaces()) {
+            while (hasChar() and buffer[pos] > ' ') {
+                if (length + 1 < capacity) token[length++] = buffer[pos];
+                pos++;
+            }
+        }
+        token[length] = '\0';
+        return length;
+    }
+};
+
+Reader reader;
+
+// ターンの持ち時間の管理。時計は入力の最初の1バイトが届いたときから進めるので、
+// 入力の読み込みや前処理にかかった時間も持ち時間に含まれる。
+// 探索ループからはisOver()を毎回呼んでよい (時計を見るのはCHECK_INTERVAL回に1回だけ)。
+// フェーズごとに、打ち切るまでにisOver()を何回呼んだかを記録しておく。リプレイではその回数をreplay()で
+// 渡すと、時計を見ずにちょうど同じ回数で打ち切るので、探索が本番と同じところで止まる。
+struct TimeManager {
+    static const int CHECK_INTERVAL = 16;
+    static const int MAX_PHASES     = 8;    // 1ターンのフェーズ数の上限 (超えた分は最後のフェーズとして扱う)
+
+    long long firstTurnBudget;  // [us]
+    long long turnBudget;       // [us]
+
+    Timer timer;
+    long long budget;
+    long long phaseEnd;     // 今のフェーズの期限 (ターン開始からの経過時間 [us])
+    int calls = 0;
+    bool over = false;
+
+    int phase = 0;
+    int work[MAX_PHASES];   // フェーズごとの、打ち切ったときのcalls (最後まで打ち切らなかったフェーズは-1)
+    bool replaying = false;
+
+    TimeManager(long long firstTurnBudget, long long turnBudget) :
+        firstTurnBudget(firstTurnBudget), turnBudget(turnBudget),
+        budget(firstTurnBudget), phaseEnd(firstTurnBudget) {}
+
+    void startTurn(const Timer& arrival, bool firstTurn) {
+        timer  = arrival;
+        budget = firstTurn ? firstTurnBudget : turnBudget;
+        phase  = -1;
+        beginPhase(1.0);
+    }
+
+    // ここから持ち時間のratioの割合 (ターン開始から数える) までを今のフェーズに使う
+    void beginPhase(double ratio) {
+        if (phase + 1 < MAX_PHASES) phase++;
+        phaseEnd = (long long)(budget * ratio);
+        calls    = 0;
+        if (!replaying) work[phase] = timer.elapsedMicros() >= phaseEnd ? 0 : -1;
+        over = work[phase] == 0;
+    }
+
+    long long elapsedMicros() const {
+        return timer.elapsedMicros();
+    }
+
+    bool isOver() {
+        if (!over) {
+            if (!replaying and (calls + 1) % CHECK_INTERVAL == 0 and timer.elapsedMicros() >= phaseEnd) {
+                work[phase] = calls;
+            }
+            over = calls++ == work[phase];
+        }
+        return over;
+    }
+
+    // このターンのフェーズごとの記録 (リプレイログに書き出す)
+    vector<int> record() const {
+        return vector<int>(work, work + phase + 1);
+    }
+
+    // 以降のターンを、記録した回数で打ち切るようにする (startTurnの前に呼ぶ)
+    void replay(const vector<int>& record) {
+        replaying = true;
+        for (int i = 0; i < MAX_PHASES; i++) work[i] = i < (int)record.size() ? record[i] : -1;
+    }
+};
+
+// 1ターン目は1000ms、それ以降は50msの制限に対して余裕を持たせる
+TimeManager timeManager(900 * 1000, 45 * 1000);
+
+//
+// ターンごとの計測
+// -DBOT_STATSを付けてコンパイルしたときだけ、戦略ごとの時間と状態の生成数・評価回数を数え、
+// ターンの終わりに1行だけ標準エラー出力に書き出す。付けなければ何も生成されない。
+//
+namespace Stats {
+    enum Phase { STRATEGY1, STRATEGY2, PLAN_SEARCH, OPPONENT, PHASE_COUNT };
+    enum Counter { STATES, EVALUATIONS, RESOLUTIONS, COUNTER_COUNT };
+
+#ifdef BOT_STATS
+    const char* PHASE_NAMES[]   = {"strategy1", "strategy2", "search", "opponent"};
+    const char* COUNTER_NAMES[] = {"states", "evals", "resolutions"};
+
+    long long phaseMicros[PHASE_COUNT];
+    long long counters[COUNTER_COUNT];
+    int chosenStrategy, chosenScore;
+
+    inline void count(Counter counter) {
+        counters[counter]++;
+    }
+
+    inline void choose(int strategy, int score) {
+        chosenStrategy = strategy;
+        chosenScore    = score;
+    }
+
+    // 生存期間の時間をphaseに加算する
+    struct Scope {
+        Phase phase;
+        Timer timer;
+
+        explicit Scope(Phase phase) : phase(phase) {}
+        ~Scope() { phaseMicros[phase] += timer.elapsedMicros(); }
+    };
+
+    void flush(int turn) {
+        char line[256];
+        int len = snprintf(line, sizeof(line), "turn %d |", turn);
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            len += snprintf(line + len, sizeof(line) - len, " %s %lldus", PHASE_NAMES[i], phaseMicros[i]);
+        }
+        len += snprintf(line + len, sizeof(line) - len, " |");
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            len += snprintf(line + len, sizeof(line) - len, " %s %lld", COUNTER_NAMES[i], counters[i]);
+        }
+        snprintf(line + len, sizeof(line) - len, " | strategy%d score %d", chosenStrategy, chosenScore);
+        fprintf(stderr, "%s\n", line);
+        fflush(stderr);
+
+        memset(phaseMicros, 0, sizeof(phaseMicros));
+        memset(counters, 0, sizeof(counters));
+    }
+#else
+    inline void count(Counter) {}
+    inline void choose(int, int) {}
+
+    struct Scope {
+        explicit Scope(Phase) {}
+    };
+
+    inline void flush(int) {}
+#endif
+}
+
+// 環境変数BOT_SEEDがあればそれをシードにする (同じ手を再現するため)
+unsigned long long initialSeed() {
+    const char* env = getenv("BOT_SEED");
+    if (env != nullptr) return strtoull(env, nullptr, 10);
+    random_device rnd;
+    return rnd();
+}
+
+// PCG32 (64bitの線形合同法の状態を、xorshiftと回転で32bitに縮めて出力する)。
+// 状態が16バイトで呼び出しはインライン展開されるので、mt19937よりずっと軽い
+struct PCG32 {
+    uint64_t state;
+    uint64_t inc;
+
+    explicit PCG32(uint64_t seed, uint64_t stream = 0) {
+        state = 0;
+        inc   = (stream << 1) | 1;
+        next();
+        state += seed;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        uint32_t xorshifted = ((old >> 18) ^ old) >> 27;
+        uint32_t rot        = old >> 59;
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+
+    // [0, n)の一様な整数。剰余の代わりに掛け算の上位32bitを使い (Lemireの方法)、
+    // 偏りが出る下位の範囲に入ったときだけ引き直す
+    uint32_t bounded(uint32_t n) {
+        uint64_t m   = (uint64_t)next() * n;
+        uint32_t low = (uint32_t)m;
+        if (low < n) {
+            uint32_t threshold = -n % n;
+            while (low < threshold) {
+                m   = (uint64_t)next() * n;
+                low = (uint32_t)m;
+            }
+        }
+        return m >> 32;
+    }
+};
+
+unsigned long long seed = initialSeed();
+thread_local PCG32 rng(seed);   // スレッドごとに独立した状態を持つ
+
+// 呼び出したスレッドの乱数を初期化する (別のスレッドではstreamを変えると系列が重ならない)
+void setSeed(unsigned long long s, uint64_t stream = 0) {
+    seed = s;
+    rng  = PCG32(s, stream);
+}
+
+// ターンの初めに乱数を初期化し直す。ターンごとの乱数列がシードとターン番号だけで決まるので、
+// リプレイで途中のターンを1つだけ再現できる
+void seedTurn(int turn) {
+    rng = PCG32(seed ^ turn);
+}
+
+// n未満の非負整数をランダムに生成する
 int randInt(int n) {
-    static random_device rnd;
-    static mt19937 mt(rnd());
-    return mt();
+    return rng.bounded(n);
 }
 
-void inputGameConstants() {
-    cin >> planetCount >> edgeCount; cin.ignore();
+// 辺のリスト (リプレイログに書き出すために残しておく)
+vector<int> edges;
 
+// 辺のリストからCSRと隣接マスクを作る。隣接惑星の並びは辺の入力順
+void buildGraph() {
+    int degree[MAX_PLANET_COUNT] = {};
+    for (int v : edges) degree[v]++;
+
+    offsets[0] = 0;
+    for (int id = 0; id < MAX_PLANET_COUNT; id++) {
+        offsets[id + 1] = offsets[id] + degree[id];
+        neighborMask[id] = PlanetMask();
+    }
+
+    int cursor[MAX_PLANET_COUNT];
+    copy(offsets, offsets + MAX_PLANET_COUNT, cursor);
+    neighbors.resize(2 * edgeCount);
     for (int i = 0; i < edgeCount; i++) {
-        int planetA, planetB;
-        cin >> planetA >> planetB; cin.ignore();
+        int planetA = edges[2 * i],
+            planetB = edges[2 * i + 1];
+        neighbors[cursor[planetA]++] = planetB;
+        neighbors[cursor[planetB]++] = planetA;
+        neighborMask[planetA].set(planetB);
+        neighborMask[planetB].set(planetA);
+    }
+}
 
-        G[planetA].push_back(planetB);
-        G[planetB].push_back(planetA);
+void inputGameConstants() {
+    planetCount = reader.readInt();
+    edgeCount   = reader.readInt();
+
+    edges.resize(2 * edgeCount);
+    for (int i = 0; i < 2 * edgeCount; i++) {
+        edges[i] = reader.readInt();
     }
+    buildGraph();
 }
 
 GameState inputPlanets() {
     GameState state;
     for (int i = 0; i < planetCount; i++) {
-        cin >> state.myUnits[i] >> state.myTolerance[i]
-            >> state.otherUnits[i] >> state.otherTolerance[i] >> state.canAssign[i]; cin.ignore();
+        state.myUnits[i]        = reader.readInt();
+        state.myTolerance[i]    = reader.readInt();
+        state.otherUnits[i]     = reader.readInt();
+        state.otherTolerance[i] = reader.readInt();
+        state.canAssign[i]      = reader.readInt();
     }
+    state.initEvaluation();
     return state;
 }
 
 GameState advanceGameState(GameState& state, Move& move) {
+    Stats::count(Stats::STATES);
     GameState nextState(state);
-    if (move.type == NORMAL) {
-        nextState.myUnits[move.target]++;
-    } else if (move.target >= 0) {  // UNIT SPREAD
-        nextState.myUnits[move.target] -= 5;
-        for (int neighbor : G[move.target]) {
-            nextState.myUnits[neighbor]++;
-        }
-    }
+    nextState.apply(move);
     return nextState;
 }
 
 array<int, MAX_PLANET_COUNT> evaluatePlanets(const GameState& state) {
+    Stats::count(Stats::EVALUATIONS);
     array<int, MAX_PLANET_COUNT> scores;    // 0で初期化される
     scores.fill(0);
 
@@ -115,7 +630,7 @@ array<int, MAX_PLANET_COUNT> evaluatePlanets(const GameState& state) {
         // * 周りの味方の数と敵の数
         // * 簡単な敵の攻撃パターンの予測
 
-        for (int neighbor : G[id]) {
+        for (int neighbor : adjacent(id)) {
             int advantage = state.myUnits[neighbor] - state.myUnits[neighbor];
             if (advantage > 0) scores[id] += 1;
             else if (advantage < 0) scores[id] -= 1;
@@ -124,33 +639,23 @@ array<int, MAX_PLANET_COUNT> evaluatePlanets(const GameState& state) {
     return scores;
 }
 
+// 評価値はGameState::applyで差分更新されている (計算はGameState::computeContributionを参照)
 int evaluateGameState(const GameState& state) {
-    int score = 0;
-    for (int id = 0; id < planetCount; id++) {
-        int advantage = state.myUnits[id] - state.otherUnits[id];
-    if (advantage <= 0) continue;
-
-        int friendCount = 0,
-            enemyCount  = 0;
-        for (int neighbor : G[id]) {
-            int nAdvantage = state.myUnits[neighbor] - state.otherUnits[neighbor];
-            if (nAdvantage > 0) friendCount++;
-            else if (nAdvantage < 0) enemyCount++;
-        }
-
-        if (friendCount > enemyCount) advantage++;
-        else if (friendCount < enemyCount) advantage--;
-
-        score += 20 * (advantage > 0) - enemyCount;
-    }
-    return score;
+    Stats::count(Stats::EVALUATIONS);
+    return state.total;
 }
 
 pair<Move, int> suggestUnitSpreadPlanet(GameState& state) {
     static Move none(UNIT_SPREAD, -1);
 
+    // 行動を適用して評価し、元に戻す
     auto evaluateMove = [&](Move& m) {
-        return evaluateGameState(advanceGameState(state, m));
+        Stats::count(Stats::STATES);
+        StateUndo undo;
+        state.apply(m, &undo);
+        int score = evaluateGameState(state);
+        state.undo(m, undo);
+        return score;
     };
 
     vector<pair<Move, int>> moves = { make_pair(none, evaluateMove(none)) };
@@ -178,11 +683,10 @@ pair<Strategy, int> suggestStrategy1(GameState& state) {
         int target = -1;
         for (int id = 0; id < planetCount; id++) {
             if (target < 0 or scores[id] > scores[target]) target = id;
-            // cerr << "scores[" << id << "] " << scores[id] << endl;
         }
         Move move(NORMAL, target);
-        
-        curState = advanceGameState(state, move);
+
+        curState.apply(move);
         strategy.push_back(move);
     }
     auto recommended = suggestUnitSpreadPlanet(curState);
@@ -192,30 +696,26 @@ pair<Strategy, int> suggestStrategy1(GameState& state) {
 }
 
 pair<Strategy, int> suggestStrategy2(GameState& state) {
+    // stateに5つ置いて評価した後、置いた分を取り消してstateを元に戻す
     auto concentrateAndUnitSpread = [&](int target) {
-        GameState curState = state;
         Strategy strategy;
+        StateUndo undo[5];
         for (int i = 0; i < 5; i++) {
             Move move(NORMAL, target);
-            curState = advanceGameState(curState, move);
+            state.apply(move, &undo[i]);
             strategy.push_back(move);
         }
-        auto recommended = suggestUnitSpreadPlanet(curState);
+        auto recommended = suggestUnitSpreadPlanet(state);
         strategy.push_back(recommended.first);
 
+        for (int i = 4; i >= 0; i--) state.undo(strategy[i], undo[i]);
         return make_pair(strategy, recommended.second);
-
-        if (target == 3) {
-            cerr << "target: " << target << " score: " << evaluateGameState(curState) << endl;
-            for (int id = 0; id < planetCount; id++) {
-                cerr << "id: " << id << " my: " << curState.myUnits[id] << " other: " << curState.otherUnits[id] << endl;
-            }
-        }
     };
 
     Strategy strategy;
     int score = -INF;
-    for (int id = 0; id < planetCount; id++) {
+    // 持ち時間が尽きたら、そこまでに調べた頂点の中から選ぶ
+    for (int id = 0; id < planetCount and !timeManager.isOver(); id++) {
         if (!state.canAssign[id]) continue;
         auto choice = concentrateAndUnitSpread(id);
 
@@ -230,31 +730,498 @@ pair<Strategy, int> suggestStrategy2(GameState& state) {
     return make_pair(strategy, score);
 }
 
+//
+// 5つの配置 + unit spreadに対するビームサーチ
+// 配置の順番は結果に影響しないので、置く惑星の番号が広義単調増加になる順番だけを調べて重複を除く。
+// 5つ置いた後の各候補について、最も良いunit spread (しない場合も含む) を選んで最終的な評価値とする。
+// 時間が残っている限りビーム幅を倍にしながら探索し直す。
+//
+const int PLACEMENT_COUNT    = 5;
+const int INITIAL_BEAM_WIDTH = 8;
+const int FINALIST_COUNT     = 16;  // 相手の行動の予測と突き合わせる候補の数
+
+// 持ち時間のうち、戦略1・戦略2までと、ビームサーチまでに使ってよい割合 (残りは相手の行動の予測に使う)
+const double STRATEGY_TIME_RATIO = 0.2;
+const double SEARCH_TIME_RATIO   = 0.8;
+
+// 1ターン分の行動 (5つの配置とunit spread) を固定長で持つ
+struct TurnPlan {
+    short targets[PLACEMENT_COUNT];
+    short spread;   // unit spreadする惑星。しないなら-1
+
+    bool operator==(const TurnPlan& plan) const {
+        return spread == plan.spread and equal(targets, targets + PLACEMENT_COUNT, plan.targets);
+    }
+};
+
+Strategy toStrategy(const TurnPlan& plan) {
+    Strategy strategy;
+    for (int i = 0; i < PLACEMENT_COUNT; i++) strategy.push_back(Move(NORMAL, plan.targets[i]));
+    strategy.push_back(Move(UNIT_SPREAD, plan.spread));
+    return strategy;
+}
+
+// 5つの配置 + unit spreadの形になっていなければfalseを返す
+bool toTurnPlan(const Strategy& strategy, TurnPlan& plan) {
+    if ((int)strategy.size() != PLACEMENT_COUNT + 1) return false;
+    for (int i = 0; i < PLACEMENT_COUNT; i++) plan.targets[i] = strategy[i].target;
+    plan.spread = strategy[PLACEMENT_COUNT].target;
+    return true;
+}
+
+struct PlanSearch {
+    struct Plan {
+        int score;
+        int count;
+        short targets[PLACEMENT_COUNT];     // 広義単調増加
+
+        bool operator>(const Plan& plan) const {
+            return score > plan.score;
+        }
+    };
+
+    struct Finalist {
+        TurnPlan plan;
+        int score;
+    };
+
+    vector<Plan> beam, candidates;
+    int bestScore;
+    Strategy bestStrategy;
+    vector<Finalist> finalists;     // 評価値の高い順にFINALIST_COUNT個まで
+
+    // 重複を除いてfinalistsに加える
+    void offer(const TurnPlan& plan, int score) {
+        for (const Finalist& finalist : finalists) {
+            if (finalist.plan == plan) return;
+        }
+        if ((int)finalists.size() == FINALIST_COUNT) {
+            if (score <= finalists.back().score) return;
+            finalists.pop_back();
+        }
+        auto it = finalists.begin();
+        while (it != finalists.end() and it->score >= score) ++it;
+        finalists.insert(it, Finalist{plan, score});
+    }
+
+    // planの配置をstateに適用する / 取り消す
+    void place(GameState& state, const Plan& plan, StateUndo* undo) {
+        for (int i = 0; i < plan.count; i++) state.apply(Move(NORMAL, plan.targets[i]), &undo[i]);
+    }
+    void unplace(GameState& state, const Plan& plan, StateUndo* undo) {
+        for (int i = plan.count - 1; i >= 0; i--) state.undo(Move(NORMAL, plan.targets[i]), undo[i]);
+    }
+
+    // 1回分のビームサーチ。全候補がビームに収まった (= 全探索できた) ときtrueを返す
+    bool run(GameState& state, int beamWidth) {
+        bool exhaustive = true;
+        StateUndo undo[PLACEMENT_COUNT + 1];
+
+        beam.assign(1, Plan{evaluateGameState(state), 0, {}});
+        for (int depth = 0; depth < PLACEMENT_COUNT; depth++) {
+            candidates.clear();
+            for (const Plan& plan : beam) {
+                if (timeManager.isOver()) return false;
+
+                place(state, plan, undo);
+                int first = plan.count > 0 ? plan.targets[plan.count - 1] : 0;
+                for (int id = first; id < planetCount; id++) {
+                    if (!state.canAssign[id]) continue;
+
+                    Move move(NORMAL, id);
+                    state.apply(move, &undo[depth]);
+                    Plan next = plan;
+                    next.targets[next.count++] = id;
+                    next.score = evaluateGameState(state);
+                    candidates.push_back(next);
+                    state.undo(move, undo[depth]);
+                }
+                unplace(state, plan, undo);
+            }
+
+            if ((int)candidates.size() > beamWidth) {
+                exhaustive = false;
+                nth_element(candidates.begin(), candidates.begin() + beamWidth, candidates.end(), greater<Plan>());
+                candidates.resize(beamWidth);
+            }
+            swap(beam, candidates);
+        }
+
+        for (const Plan& plan : beam) {
+            if (timeManager.isOver()) return false;
+
+            place(state, plan, undo);
+            auto spread = suggestUnitSpreadPlanet(state);
+            unplace(state, plan, undo);
+
+            TurnPlan turnPlan;
+            copy(plan.targets, plan.targets + PLACEMENT_COUNT, turnPlan.targets);
+            turnPlan.spread = spread.first.target;
+            offer(turnPlan, spread.second);
+
+            if (spread.second > bestScore) {
+                bestScore = spread.second;
+                bestStrategy.clear();
+                for (int i = 0; i < plan.count; i++) bestStrategy.push_back(Move(NORMAL, plan.targets[i]));
+                bestStrategy.push_back(spread.first);
+            }
+        }
+        return exhaustive;
+    }
+
+    // initialは比較対象となる既存の行動列とその評価値
+    pair<Strategy, int> search(GameState& state, const pair<Strategy, int>& initial) {
+        bestStrategy = initial.first;
+        bestScore    = initial.second;
+        finalists.clear();
+
+        for (int width = INITIAL_BEAM_WIDTH; !timeManager.isOver(); width *= 2) {
+            if (run(state, width)) break;
+        }
+        return make_pair(bestStrategy, bestScore);
+    }
+};
+
+//
+// 相手の行動の予測
+// evaluateGameStateは相手が同じターンに何もしない前提で評価しているので、最終候補は相手の行動を
+// 何通りかサンプリングし、両者の行動を同時に適用した1ターン後の局面で比べ直す。
+// 相手の行動は、相手が配置できそうな惑星のうちユニット数が競っている所ほど選ばれやすい重み付きの乱択で作る
+// (1つ目だけは重みが最大の惑星に貪欲に置く)。
+//
+const int OPPONENT_SAMPLE_COUNT = 256;
+
+// 両者の行動を同時に適用した局面の評価値を返す。stateはその場で書き換え、applyの逆順にundoして元に戻す。
+// 配置を先に全部済ませてからunit spreadする。targetsが-1の配置は何もしない。
+// (耐久度の減少は評価値に影響しないので扱わない)
+int resolveTurn(GameState& state, const TurnPlan& mine, const TurnPlan& theirs) {
+    Stats::count(Stats::RESOLUTIONS);
+    const int SPREAD = 2 * PLACEMENT_COUNT;
+    StateUndo undo[2 * (PLACEMENT_COUNT + 1)];
+
+    for (int i = 0; i < PLACEMENT_COUNT; i++) {
+        if (mine.targets[i] >= 0) state.apply(NORMAL, mine.targets[i], &undo[2 * i]);
+        if (theirs.targets[i] >= 0) state.applyOther(NORMAL, theirs.targets[i], &undo[2 * i + 1]);
+    }
+    state.apply(UNIT_SPREAD, mine.spread, &undo[SPREAD]);
+    state.applyOther(UNIT_SPREAD, theirs.spread, &undo[SPREAD + 1]);
+
+    int score = evaluateGameState(state);
+
+    state.undoOther(UNIT_SPREAD, theirs.spread, undo[SPREAD + 1]);
+    state.undo(UNIT_SPREAD, mine.spread, undo[SPREAD]);
+    for (int i = PLACEMENT_COUNT - 1; i >= 0; i--) {
+        if (theirs.targets[i] >= 0) state.undoOther(NORMAL, theirs.targets[i], undo[2 * i + 1]);
+        if (mine.targets[i] >= 0) state.undo(NORMAL, mine.targets[i], undo[2 * i]);
+    }
+    return score;
+}
+
+struct OpponentModel {
+    int count;                          // 相手が配置できそうな惑星の数
+    short planets[MAX_PLANET_COUNT];
+    int cumulative[MAX_PLANET_COUNT];   // 重みの累積和
+    vector<int> scores;
+    vector<long long> totals;
+
+    // 相手が惑星idに置く重み。ユニット数の差が小さいほど大きい
+    static int weight(const GameState& state, int id) {
+        return 1 + max(0, 8 - 2 * abs(state.myUnits[id] - state.otherUnits[id]));
+    }
+
+    // 相手のユニットがいる惑星とその隣のうち、相手の耐久度が残っている惑星を集める
+    void prepare(const GameState& state) {
+        PlanetMask occupied, assignable;
+        for (int id = 0; id < planetCount; id++) {
+            if (state.otherUnits[id] > 0) occupied.set(id);
+        }
+        occupied.forEach([&](int id) {
+            assignable.set(id);
+            assignable |= neighborMask[id];
+        });
+
+        count = 0;
+        int sum = 0;
+        assignable.forEach([&](int id) {
+            if (state.otherTolerance[id] == 0) return;
+            sum += weight(state, id);
+            planets[count]    = id;
+            cumulative[count] = sum;
+            count++;
+        });
+    }
+
+    // 相手の行動を1つ作る。stateは一時的に書き換えるが元に戻す
+    TurnPlan sample(GameState& state, bool greedy) {
+        TurnPlan plan;
+        plan.spread = -1;
+        for (int i = 0; i < PLACEMENT_COUNT; i++) {
+            int target = -1;
+            if (count > 0 and greedy) {
+                for (int k = 0; k < count; k++) {
+                    if (target < 0 or weight(state, planets[k]) > weight(state, target)) target = planets[k];
+                }
+            } else if (count > 0) {
+                int r = randInt(cumulative[count - 1]);
+                target = planets[upper_bound(cumulative, cumulative + count, r) - cumulative];
+            }
+            plan.targets[i] = target;
+            if (target >= 0) state.otherUnits[target]++;
+        }
+
+        // 乱択のときは半分の確率で、置いた後に5以上いる惑星からunit spreadする
+        if (!greedy and randInt(2) > 0) {
+            int spreadable = 0;
+            short choices[MAX_PLANET_COUNT];
+            for (int k = 0; k < count; k++) {
+                if (state.otherUnits[planets[k]] >= 5) choices[spreadable++] = planets[k];
+            }
+            if (spreadable > 0) plan.spread = choices[randInt(spreadable)];
+        }
+
+        for (int i = 0; i < PLACEMENT_COUNT; i++) {
+            if (plan.targets[i] >= 0) state.otherUnits[plan.targets[i]]--;
+        }
+        return plan;
+    }
+
+    // plansの中から、相手の行動のサンプルに対する評価値の合計が最も大きいものの番号を返す。
+    // 同点なら前にあるものを選ぶ。1つもサンプルを調べきれなければ-1
+    int choose(GameState& state, const vector<TurnPlan>& plans) {
+        prepare(state);
+        scores.assign(plans.size(), 0);
+        totals.assign(plans.size(), 0);
+
+        int samples = 0;
+        for (; samples < OPPONENT_SAMPLE_COUNT; samples++) {
+            TurnPlan theirs = sample(state, samples == 0);
+            // 途中で時間切れになったサンプルは数えない
+            for (int i = 0; i < (int)plans.size(); i++) {
+                if (timeManager.isOver()) goto done;
+                scores[i] = resolveTurn(state, plans[i], theirs);
+            }
+            for (int i = 0; i < (int)plans.size(); i++) totals[i] += scores[i];
+        }
+    done:
+        if (samples == 0) return -1;
+        return max_element(totals.begin(), totals.end()) - totals.begin();
+    }
+};
+
 Strategy developStrategy(GameState& state) {
     // 戦略1) 評価値の高いところに貪欲に5つ詰め込んでいく。 => unit spreadした方がいいのならする。
     // 戦略2) unit spreadありきの戦略
-    auto choice1 = suggestStrategy1(state);
-    auto choice2 = suggestStrategy2(state);
+    // 良い方を基準にして、ビームサーチでそれより良い行動列を探す
+    pair<Strategy, int> choice1, choice2;
+    timeManager.beginPhase(STRATEGY_TIME_RATIO);
+    {
+        Stats::Scope scope(Stats::STRATEGY1);
+        choice1 = suggestStrategy1(state);
+    }
+    {
+        Stats::Scope scope(Stats::STRATEGY2);
+        choice2 = suggestStrategy2(state);
+    }
 
-    if (choice1.second >= choice2.second) {
-        cerr << "Strategy1 [score] " << choice1.second << endl;
-        return choice1.first;
-    } else {
-        cerr << "Strategy2 [score] " << choice2.second << endl;
-        return choice2.first;
+    int chosen = 1;
+    auto best = choice1;
+    if (choice2.second > choice1.second) {
+        chosen = 2;
+        best   = choice2;
+    }
+
+    static PlanSearch searcher;
+    timeManager.beginPhase(SEARCH_TIME_RATIO);
+    {
+        Stats::Scope scope(Stats::PLAN_SEARCH);
+        auto choice3 = searcher.search(state, best);
+        if (choice3.second > best.second) {
+            chosen = 3;
+            best   = choice3;
+        }
+    }
+
+    // ここまでの最善手とビームサーチの上位の候補を、相手の行動と突き合わせて選び直す
+    static OpponentModel opponent;
+    static vector<TurnPlan> plans;
+    static vector<int> planScores;  // 相手が何もしない前提の評価値
+    timeManager.beginPhase(1.0);
+    {
+        Stats::Scope scope(Stats::OPPONENT);
+        plans.clear();
+        planScores.clear();
+        TurnPlan plan;
+        if (toTurnPlan(best.first, plan)) {
+            plans.push_back(plan);
+            planScores.push_back(best.second);
+        }
+        for (const auto& finalist : searcher.finalists) {
+            if (find(plans.begin(), plans.end(), finalist.plan) != plans.end()) continue;
+            plans.push_back(finalist.plan);
+            planScores.push_back(finalist.score);
+        }
+
+        int index = plans.size() > 1 ? opponent.choose(state, plans) : -1;
+        if (index > 0) {
+            chosen = 4;
+            best   = make_pair(toStrategy(plans[index]), planScores[index]);
+        }
     }
+
+    Stats::choose(chosen, best.second);
+    return best.first;
+}
+
+string toString(const Strategy& strategy) {
+    string res;
+    for (auto& move : strategy) res += move.output + "\n";
+    return res;
+}
+
+//
+// リプレイログ
+// 環境変数BOT_REPLAYにファイル名を指定すると、シード・グラフ・毎ターンの惑星の状態・出力をバイナリで書き出す。
+// 出力の記録には、フェーズごとに探索を打ち切ったところ (TimeManager::record) も含める。
+// ./main --replay FILE で記録した入力を、同じ乱数・同じ打ち切り位置でもう一度思考させ、
+// ターンごとの時間と出力の違いを表示する。
+//
+const char REPLAY_MAGIC[4] = {'A', 'R', 'P', '2'};
+const unsigned char REPLAY_CONSTANTS = 0;
+const unsigned char REPLAY_INPUT     = 1;
+const unsigned char REPLAY_OUTPUT    = 2;   // 打ち切り位置の個数, 打ち切り位置..., 出力の文字列
+
+FILE* replayLog = nullptr;
+
+void openReplayLog() {
+    const char* path = getenv("BOT_REPLAY");
+    if (path == nullptr or (replayLog = fopen(path, "wb")) == nullptr) return;
+    fwrite(REPLAY_MAGIC, 1, 4, replayLog);
+    fwrite(&seed, sizeof(seed), 1, replayLog);
+}
+
+void writeReplay(unsigned char kind, const vector<int>& data) {
+    if (replayLog == nullptr) return;
+    unsigned size = data.size() * sizeof(int);
+    fwrite(&kind, 1, 1, replayLog);
+    fwrite(&size, sizeof(size), 1, replayLog);
+    fwrite(data.data(), 1, size, replayLog);
+}
+
+void writeReplay(unsigned char kind, const vector<int>& work, const string& output) {
+    if (replayLog == nullptr) return;
+    int count = work.size();
+    unsigned size = sizeof(count) + count * sizeof(int) + output.size();
+    fwrite(&kind, 1, 1, replayLog);
+    fwrite(&size, sizeof(size), 1, replayLog);
+    fwrite(&count, sizeof(count), 1, replayLog);
+    fwrite(work.data(), sizeof(int), count, replayLog);
+    fwrite(output.data(), 1, output.size(), replayLog);
+    fflush(replayLog);
+}
+
+bool readReplay(FILE* in, unsigned char& kind, string& data) {
+    unsigned size;
+    if (fread(&kind, 1, 1, in) != 1 or fread(&size, sizeof(size), 1, in) != 1) return false;
+    data.resize(size);
+    return fread(&data[0], 1, size, in) == size;
+}
+
+// 惑星ごとに (myUnits, myTolerance, otherUnits, otherTolerance, canAssign) の順で並べる
+vector<int> serialize(const GameState& state) {
+    vector<int> data;
+    for (int i = 0; i < planetCount; i++) {
+        data.insert(data.end(), {state.myUnits[i], state.myTolerance[i], state.otherUnits[i],
+                                 state.otherTolerance[i], state.canAssign[i]});
+    }
+    return data;
+}
+
+GameState deserialize(const int* data) {
+    GameState state;
+    for (int i = 0; i < planetCount; i++, data += 5) {
+        state.myUnits[i]        = data[0];
+        state.myTolerance[i]    = data[1];
+        state.otherUnits[i]     = data[2];
+        state.otherTolerance[i] = data[3];
+        state.canAssign[i]      = data[4];
+    }
+    state.initEvaluation();
+    return state;
+}
+
+int runReplay(const char* path) {
+    FILE* in = fopen(path, "rb");
+    char magic[4];
+    if (in == nullptr or fread(magic, 1, 4, in) != 4 or memcmp(magic, REPLAY_MAGIC, 4) != 0 or
+        fread(&seed, sizeof(seed), 1, in) != 1) {
+        cerr << "invalid replay file: " << path << endl;
+        return 1;
+    }
+    setSeed(seed);
+
+    unsigned char kind;
+    string data;
+    GameState game;
+    int turn = 0;
+    while (readReplay(in, kind, data)) {
+        const int* values = reinterpret_cast<const int*>(data.data());
+        if (kind == REPLAY_CONSTANTS) {
+            planetCount = values[0];
+            edgeCount   = values[1];
+            edges.assign(values + 2, values + 2 + 2 * edgeCount);
+            buildGraph();
+        } else if (kind == REPLAY_INPUT) {
+            game = deserialize(values);
+            turn++;
+        } else {
+            vector<int> work(values + 1, values + 1 + values[0]);
+            string logged = data.substr((1 + values[0]) * sizeof(int));
+
+            Timer timer;
+            timeManager.replay(work);
+            timeManager.startTurn(timer, turn == 1);
+            seedTurn(turn);
+            string result = toString(developStrategy(game));
+            long long elapsed = timer.elapsedMicros();
+
+            replace(result.begin(), result.end(), '\n', ' ');
+            replace(logged.begin(), logged.end(), '\n', ' ');
+            printf("turn %d  %lld us  output: %s\n", turn, elapsed, result.c_str());
+            printf("turn %d  logged: %s%s\n", turn, logged.c_str(), logged == result ? "" : "  (differs)");
+            fflush(stdout);
+            Stats::flush(turn);
+        }
+    }
+    fclose(in);
+    return 0;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    if (argc >= 3 and string(argv[1]) == "--replay") {
+        return runReplay(argv[2]);
+    }
+    openReplayLog();
+
     inputGameConstants();
 
-    while (true) {
+    vector<int> constants = {planetCount, edgeCount};
+    constants.insert(constants.end(), edges.begin(), edges.end());
+    writeReplay(REPLAY_CONSTANTS, constants);
+
+    for (int turn = 1; ; turn++) {
         auto game = inputPlanets();
+        if (reader.failed) break;
+        timeManager.startTurn(reader.arrival, turn == 1);
+        writeReplay(REPLAY_INPUT, serialize(game));
+
+        seedTurn(turn);
         auto moves = developStrategy(game);
 
-        for (auto& move : moves) {
-            cout << move.output << endl;
-        }
+        string res = toString(moves);
+        writeReplay(REPLAY_OUTPUT, timeManager.record(), res);
+        cout << res << flush;
+        reader.nextTurn();
+        Stats::flush(turn);
     }
 
     return 0;
@@ -1,11 +1,142 @@
 #include <iostream>
 #include <vector>
-#include <queue>
-#include <tuple>
+#include <algorithm>
 #include <cstring>
+#include <chrono>
+#include <cstdint>
+#include <cassert>
+#include <unistd.h>
+
+// Timer / ReaderはCode_of_Kutulu/main.ccからの写し (std::を付けたところだけ違う)。直すときは向こうを直してから写す
+struct Timer {
+    std::chrono::steady_clock::time_point start;
+
+    Timer() { reset(); }
+
+    void reset() {
+        start = std::chrono::steady_clock::now();
+    }
+
+    // 経過時間 [us]
+    long long elapsedMicros() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// 標準入力をread()でまとめて読み込み、数値と単語を自前で解析する
+struct Reader {
+    static const int BUFFER_SIZE = (1 << 16);
+
+    char buffer[BUFFER_SIZE];
+    int pos = 0;
+    int len = 0;
+    bool eof = false;       // read()がこれ以上データを返さない
+    bool failed = false;    // 入力が尽きた状態で読もうとした
+
+    Timer arrival;          // このターンの入力の最初の1バイトが届いた時刻
+    bool waiting = true;    // 次のターンの入力がまだ届いていない
+
+    // 手元のデータを入力として使う (ベンチマーク用)
+    void load(const char* data, int size) {
+        assert(size <= BUFFER_SIZE);
+        memcpy(buffer, data, size);
+        pos = 0;
+        len = size;
+        eof = true;
+        failed = false;
+        arrival.reset();
+        waiting = false;
+    }
+
+    // 出力を終えたら呼ぶ。次に届いたデータの時刻をそのターンの開始とする
+    void nextTurn() {
+        while (pos < len and buffer[pos] <= ' ') pos++;
+        waiting = (pos == len);
+        if (!waiting) arrival.reset();  // 既に次の入力が届いている
+    }
+
+    bool fill() {
+        if (eof) return false;
+        ssize_t n = read(0, buffer, BUFFER_SIZE);
+        if (n <= 0) {
+            eof = true;
+            return false;
+        }
+        pos = 0;
+        len = n;
+        if (waiting) {
+            arrival.reset();
+            waiting = false;
+        }
+        return true;
+    }
+
+    bool hasChar() {
+        return pos < len or fill();
+    }
+
+    // 空白を読み飛ばす。読める文字がなければfailedを立てる
+    bool skipSpaces() {
+        while (hasChar() and buffer[pos] <= ' ') pos++;
+        if (!hasChar()) {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    int readInt() {
+        if (!skipSpaces()) return 0;
+
+        bool negative = (buffer[pos] == '-');
+        if (negative) pos++;
+
+        int value = 0;
+        while (hasChar() and '0' <= buffer[pos] and buffer[pos] <= '9') {
+            value = value * 10 + (buffer[pos++] - '0');
+        }
+        return negative ? -value : value;
+    }
+
+    // 空白までをtokenに書き込み、長さを返す (capacity - 1文字を超える分は捨てる)
+    int readToken(char* token, int capacity) {
+        int length = 0;
+        if (skipSpaces()) {
+            while (hasChar() and buffer[pos] > ' ') {
+                if (length + 1 < capacity) token[length++] = buffer[pos];
+                pos++;
+            }
+        }
+        token[length] = '\0';
+        return length;
+    }
+};
+
+Reader reader;
+
+enum EntityType {
+    TYPE_EXPLORER,
+    TYPE_WANDERER,
+    TYPE_SLASHER,
+    TYPE_EFFECT_PLAN,
+    TYPE_EFFECT_LIGHT,
+    TYPE_EFFECT_SHELTER,
+    TYPE_EFFECT_YELL,
+    TYPE_UNKNOWN,
+};
+
+EntityType parseEntityType(const char* token) {
+    static const char* names[] = {
+        "EXPLORER", "WANDERER", "SLASHER", "EFFECT_PLAN", "EFFECT_LIGHT", "EFFECT_SHELTER", "EFFECT_YELL",
+    };
+    for (int i = 0; i < TYPE_UNKNOWN; i++) {
+        if (strcmp(token, names[i]) == 0) return (EntityType)i;
+    }
+    return TYPE_UNKNOWN;
+}
 
 struct Entity {
-    std::string entityType;
+    EntityType entityType;
     int id;
     int x;
     int y;
@@ -15,7 +146,15 @@ struct Entity {
 
     static Entity input() {
         Entity e;
-        std::cin >> e.entityType >> e.id >> e.x >> e.y >> e.param0 >> e.param1 >> e.param2; std::cin.ignore();
+        char token[16];
+        reader.readToken(token, sizeof(token));
+        e.entityType = parseEntityType(token);
+        e.id     = reader.readInt();
+        e.x      = reader.readInt();
+        e.y      = reader.readInt();
+        e.param0 = reader.readInt();
+        e.param1 = reader.readInt();
+        e.param2 = reader.readInt();
         return e;
     }
 };
@@ -28,37 +167,59 @@ std::vector<std::string> map;
 
 int dx[] = {1, 0, -1, 0},
     dy[] = {0, 1, 0, -1};
-int score[30][30];
 
-int nearestWanderer(std::vector<Entity>& entities, int cx, int cy) {
-    int dist[30][30];
-    memset(dist, -1, sizeof(dist));
+// 盤面の最大サイズ (main.ccと同じ)
+const int MAX_WIDTH  = 24;
+const int MAX_HEIGHT = 20;
+constexpr std::uint8_t UNREACHABLE = 255;
 
-    using T = std::tuple<int, int, int>;
+// 各マスから最も近い (出現済みの) WandererかSlasherまでの距離。x * MAX_HEIGHT + yの順に並べる。
+// 毎ターン1回、全ての敵を始点にした幅優先探索で作るので、敵が増えても手間は変わらない
+std::uint8_t wandererDistance[MAX_WIDTH * MAX_HEIGHT];
 
-    std::queue<T> Q;
-    Q.push(T(cx, cy, 0));
-    dist[cx][cy] = 0;
+bool isActiveEnemy(const Entity& e) {
+    if (e.entityType == TYPE_WANDERER) return e.param1 == 1;   // 1: WANDERING
+    if (e.entityType == TYPE_SLASHER) return e.param1 != 0;    // 0: SPAWNING
+    return false;
+}
 
-    while (!Q.empty()) {
-        int x, y, d;
-        std::tie(x, y, d) = Q.front(); Q.pop();
+void buildWandererDistance(const std::vector<Entity>& entities) {
+    static short queue[MAX_WIDTH * MAX_HEIGHT];
+    int head = 0,
+        tail = 0;
 
-        for (auto& e : entities) {
-            if (e.entityType == "WANDERER" and e.param1 == 1 and e.x == x and e.y == y) {
-                return d;
-            }
-            for (int i = 0; i < 4; i++) {
-                int nx = x + dx[i],
-                    ny = y + dy[i];
-                if (map[nx][ny] != '#' and dist[nx][ny] < 0) {
-                    Q.push(T(nx, ny, d + 1));
-                    dist[nx][ny] = d + 1;
-                }
+    memset(wandererDistance, UNREACHABLE, sizeof(wandererDistance));
+    for (auto& e : entities) {
+        if (!isActiveEnemy(e)) continue;
+        int c = e.x * MAX_HEIGHT + e.y;
+        if (wandererDistance[c] == 0) continue;
+        wandererDistance[c] = 0;
+        queue[tail++] = c;
+    }
+
+    while (head < tail) {
+        int c = queue[head++],
+            x = c / MAX_HEIGHT,
+            y = c % MAX_HEIGHT;
+        // 255はUNREACHABLEと区別できないので、それより遠いマスは254のままにする
+        std::uint8_t d = std::min(wandererDistance[c] + 1, UNREACHABLE - 1);
+
+        for (int i = 0; i < 4; i++) {
+            int nx = x + dx[i],
+                ny = y + dy[i],
+                nc = nx * MAX_HEIGHT + ny;
+            if (map[nx][ny] != '#' and wandererDistance[nc] == UNREACHABLE) {
+                wandererDistance[nc] = d;
+                queue[tail++] = nc;
             }
         }
     }
-    return inf;
+}
+
+// buildWandererDistanceの後に呼ぶ
+int nearestWanderer(int x, int y) {
+    std::uint8_t d = wandererDistance[x * MAX_HEIGHT + y];
+    return d == UNREACHABLE ? inf : d;
 }
 
 std::string think(std::vector<Entity>& entities) {
@@ -67,47 +228,47 @@ std::string think(std::vector<Entity>& entities) {
     int bestX = me.x,
         bestY = me.y;
 
+    buildWandererDistance(entities);
+
     for (int i = 0; i < 4; i++) {
         int nx = me.x + dx[i],
             ny = me.y + dy[i];
         
-        // std::cerr << nx << ", " << ny << " score is " << score[nx][ny] << std::endl;
         if (map[nx][ny] == '#') continue;
         
-        if (nearestWanderer(entities, nx, ny) > nearestWanderer(entities, bestX, bestY)) {
+        if (nearestWanderer(nx, ny) > nearestWanderer(bestX, bestY)) {
             bestX = nx;
             bestY = ny;
         }
     }
-    // std::cerr << me.x << ", " << me.y << " score is " << score[me.x][me.y] << std::endl;
 
     return "MOVE " + std::to_string(bestX) + " " + std::to_string(bestY);
 }
 
 int main() {
-    std::cin >> width; std::cin.ignore();
-    std::cin >> height; std::cin.ignore();
+    width  = reader.readInt();
+    height = reader.readInt();
 
     map.resize(width, "");
     for (int y = 0; y < height; y++) {
-        std::string row;
-        std::getline(std::cin, row);
+        char row[MAX_WIDTH + 1];
+        reader.readToken(row, sizeof(row));
 
         for (int x = 0; x < width; x++) {
             map[x].push_back(row[x]);
         }
     }
 
-    int sanityLossLonely; // how much sanity you lose every turn when alone, always 3 until wood 1
-    int sanityLossGroup; // how much sanity you lose every turn when near another player, always 1 until wood 1
-    int wandererSpawnTime; // how many turns the wanderer take to spawn, always 3 until wood 1
-    int wandererLifeTime; // how many turns the wanderer is on map after spawning, always 40 until wood 1
-    std::cin >> sanityLossLonely >> sanityLossGroup >> wandererSpawnTime >> wandererLifeTime; std::cin.ignore();
+    // 以下の定数は今のAIでは使わないので読み捨てる
+    reader.readInt(); // sanityLossLonely: how much sanity you lose every turn when alone, always 3 until wood 1
+    reader.readInt(); // sanityLossGroup: how much sanity you lose every turn when near another player, always 1 until wood 1
+    reader.readInt(); // wandererSpawnTime: how many turns the wanderer take to spawn, always 3 until wood 1
+    reader.readInt(); // wandererLifeTime: how many turns the wanderer is on map after spawning, always 40 until wood 1
 
     // game loop
     while (true) {
-        int entityCount; // the first given entity corresponds to your explorer
-        std::cin >> entityCount; std::cin.ignore();
+        int entityCount = reader.readInt(); // the first given entity corresponds to your explorer
+        if (reader.failed) break;
 
         std::vector<Entity> entities(entityCount);
 
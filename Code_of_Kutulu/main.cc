@@ -1,12 +1,16 @@
 #include <iostream>
-#include <map>
 #include <algorithm>
 #include <vector>
 #include <array>
-#include <queue>
 #include <functional>
 #include <assert.h>
 #include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
 using namespace std;
 
 const int MAX_WIDTH  = 24;
@@ -14,9 +18,105 @@ const int MAX_HEIGHT = 20;
 
 const int INF = (1 << 28);
 
+// Timer / Reader / TimeManager / PCG32はこのファイルのものを正とし、Amadeus_Challenge/main.cc,
+// Legends_of_Code_and_Magic/main.cc, Code_of_Kutulu/ai.cppに写して使っている。
+// 直すときはここを直してから写し先にも反映する (持ち時間の値だけは各ボットで決める)。
+struct Timer {
+    chrono::steady_clock::time_point start;
+
+    Timer() { reset(); }
+
+    void reset() {
+        start = chrono::steady_clock::now();
+    }
+
+    // 経過時間 [us]
+    long long elapsedMicros() const {
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+//
+// ターンごとの計測
+// -DBOT_STATSを付けてコンパイルしたときだけ、探索の時間と展開ノード数・評価回数を数え、
+// ターンの終わりに1行だけ標準エラー出力に書き出す。付けなければ何も生成されない。
+//
+namespace Stats {
+    enum Phase { SEARCH, PHASE_COUNT };
+    enum Counter { NODES, EVALUATIONS, COUNTER_COUNT };
+
+#ifdef BOT_STATS
+    const char* PHASE_NAMES[]   = {"search"};
+    const char* COUNTER_NAMES[] = {"nodes", "evals"};
+
+    long long phaseMicros[PHASE_COUNT];
+    long long counters[COUNTER_COUNT];
+
+    inline void count(Counter counter) {
+        counters[counter]++;
+    }
+
+    // 生存期間の時間をphaseに加算する
+    struct Scope {
+        Phase phase;
+        Timer timer;
+
+        explicit Scope(Phase phase) : phase(phase) {}
+        ~Scope() { phaseMicros[phase] += timer.elapsedMicros(); }
+    };
+
+    void flush(int turn) {
+        char line[256];
+        int len = snprintf(line, sizeof(line), "turn %d |", turn);
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            len += snprintf(line + len, sizeof(line) - len, " %s %lldus", PHASE_NAMES[i], phaseMicros[i]);
+        }
+        len += snprintf(line + len, sizeof(line) - len, " |");
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            len += snprintf(line + len, sizeof(line) - len, " %s %lld", COUNTER_NAMES[i], counters[i]);
+        }
+        fprintf(stderr, "%s\n", line);
+        fflush(stderr);
+
+        memset(phaseMicros, 0, sizeof(phaseMicros));
+        memset(counters, 0, sizeof(counters));
+    }
+#else
+    inline void count(Counter) {}
+
+    struct Scope {
+        explicit Scope(Phase) {}
+    };
+
+    inline void flush(int) {}
+#endif
+}
+
+// entityの種類
+enum EntityType {
+    TYPE_EXPLORER,
+    TYPE_WANDERER,
+    TYPE_SLASHER,
+    TYPE_EFFECT_PLAN,
+    TYPE_EFFECT_LIGHT,
+    TYPE_EFFECT_SHELTER,
+    TYPE_EFFECT_YELL,
+    TYPE_UNKNOWN,
+};
+
+EntityType parseEntityType(const char* token) {
+    static const char* names[] = {
+        "EXPLORER", "WANDERER", "SLASHER", "EFFECT_PLAN", "EFFECT_LIGHT", "EFFECT_SHELTER", "EFFECT_YELL",
+    };
+    for (int i = 0; i < TYPE_UNKNOWN; i++) {
+        if (strcmp(token, names[i]) == 0) return (EntityType)i;
+    }
+    return TYPE_UNKNOWN;
+}
+
 // entityを表す構造体
 struct Entity {
-    string entityType;
+    EntityType entityType;
     int id;
     int x;
     int y;
@@ -25,60 +125,114 @@ struct Entity {
     int param2;
 
     Entity() {}
-    Entity(string entityType, int id, int x, int y, int param0, int param1, int param2):
+    Entity(EntityType entityType, int id, int x, int y, int param0, int param1, int param2):
         entityType(entityType), id(id), x(x), y(y), param0(param0), param1(param1), param2(param2) {}
 };
 
-// ビットマスク関連
+// 迷路のマスの種類 (mazeのビットマスク。値はリプレイログに書くので変えない)
 using BitMask = int;
 
-const BitMask BLANK    = 0;
-const BitMask EXPLORER = (1 << 0);
-const BitMask WANDERER = (1 << 1);
-const BitMask SLASHER  = (1 << 2);
-const BitMask WALL     = (1 << 3);
-const BitMask SPAWN    = (1 << 4);
+const BitMask WALL  = (1 << 3);
+const BitMask SPAWN = (1 << 4);
 
 // EFFECT_PLAN, EFFECT_LIGHT, EFFECT_SHELTER, EFFECT_YELLは無視
 
-using Map = array<array<BitMask, MAX_HEIGHT>, MAX_WIDTH>;
+// 自分の行動
+enum ActionType { ACTION_WAIT, ACTION_MOVE, ACTION_PLAN, ACTION_LIGHT };
+
+struct Action {
+    int8_t type;
+    int8_t x, y;    // MOVEの行き先 (隣のマス)
+
+    Action() : type(ACTION_WAIT), x(0), y(0) {}
+    Action(int type, int x = 0, int y = 0) : type(type), x(x), y(y) {}
+};
 
-Map buildMap(vector<Entity>& entities) {
-    Map map;
-    // mazeとentitiesからmapを作り上げる
-    return map;
+string toString(const Action& action) {
+    switch (action.type) {
+    case ACTION_MOVE:  return "MOVE " + to_string(action.x) + " " + to_string(action.y);
+    case ACTION_PLAN:  return "PLAN";
+    case ACTION_LIGHT: return "LIGHT";
+    default:           return "WAIT";
+    }
 }
 
+// WandererとSlasherの状態 (入力のparam1)
+enum MinionState { STATE_SPAWNING, STATE_WANDERING, STATE_STALKING, STATE_RUSHING, STATE_STUNNED };
+
+const int MAX_EXPLORERS = 4;
+const int MAX_MINIONS   = 64;
+
+// シミュレーション用のExplorer。値はどれも小さいので詰めて持つ
+struct Explorer {
+    int16_t id;
+    int8_t x, y;
+    int16_t sanity;         // 0以下なら脱落している
+    int8_t plans, lights;   // PLAN, LIGHTの残り回数
+    int8_t planTurns;       // PLANの効果の残りターン
+    int8_t lightTurns;      // LIGHTの効果の残りターン
+};
+
+// シミュレーション用のWanderer・Slasher
+struct Minion {
+    int8_t type;                // TYPE_WANDERER / TYPE_SLASHER
+    int8_t state;               // MinionState
+    int8_t x, y;
+    int16_t timer;              // 状態が変わるまで (出現済みのWandererなら消えるまで) の残りターン
+    int8_t targetX, targetY;    // Slasherが最後に標的を見た位置
+};
+
 // ゲームの状態を表す構造体
 // [ルール]
 // 引数で渡すときは参照渡し、返り値は実体で扱うものとする。
 // 値として扱うときは変数名としてnode、参照として扱うときはnowやnext、nなどとする。
+// 固定長の配列だけで持つので、コピーはmemcpy 1回で済む。explorers[0]が自分。
 struct Node {
-    Map map;
-    Node *parent;
-    string output;
-    vector<Entity> entities;
-    int planningDuration;
-    int lightingDuration;
+    uint32_t trace;     // BeamSearchで親をたどるための記録番号
     int score;
+    int8_t explorerCount;
+    int8_t minionCount;
+    Explorer explorers[MAX_EXPLORERS];
+    Minion minions[MAX_MINIONS];
 
     Node() {}
-    Node(vector<Entity>& entities, int planningDuration, int lightingDuration):
-            entities(entities), planningDuration(planningDuration), lightingDuration(lightingDuration) {
-        map    = buildMap(entities);
-        parent = nullptr;
-        score  = 0;
-    }
-    Node(int entityCount) {
-        entities.resize(entityCount);
-    }
-    Node(Node* n) {
-        map              = n->map;
-        parent           = n;
-        entities         = n->entities;
-        planningDuration = n->planningDuration;
-        lightingDuration = n->lightingDuration;
-        score            = n->score;
+    Node(vector<Entity>& entities, int planningDuration, int lightingDuration) {
+        trace         = 0;
+        score         = 0;
+        explorerCount = 0;
+        minionCount   = 0;
+        for (auto& e : entities) {
+            if (e.entityType == TYPE_EXPLORER and explorerCount < MAX_EXPLORERS) {
+                explorers[explorerCount++] = Explorer{(int16_t)e.id, (int8_t)e.x, (int8_t)e.y, (int16_t)e.param0,
+                                                      (int8_t)e.param1, (int8_t)e.param2, 0, 0};
+            }
+        }
+        // WandererとSlasherのparam2は標的のExplorerのid (標的がなければ-1)。targetX, targetYはその位置とし、
+        // 標的がいなければ自分のマスにする。RUSHINGで入力されたSlasherは次のターンにここへ飛び込む
+        for (auto& e : entities) {
+            if ((e.entityType != TYPE_WANDERER and e.entityType != TYPE_SLASHER) or minionCount >= MAX_MINIONS) continue;
+            Minion m = Minion{(int8_t)e.entityType, (int8_t)e.param1, (int8_t)e.x, (int8_t)e.y,
+                              (int16_t)e.param0, (int8_t)e.x, (int8_t)e.y};
+            for (int i = 0; i < explorerCount; i++) {
+                if (explorers[i].id != e.param2) continue;
+                m.targetX = explorers[i].x;
+                m.targetY = explorers[i].y;
+            }
+            minions[minionCount++] = m;
+        }
+        // 効果はparam0が残りターン、param1が使ったExplorerのid
+        for (auto& e : entities) {
+            if (e.entityType != TYPE_EFFECT_PLAN and e.entityType != TYPE_EFFECT_LIGHT) continue;
+            for (int i = 0; i < explorerCount; i++) {
+                if (explorers[i].id != e.param1) continue;
+                if (e.entityType == TYPE_EFFECT_PLAN) explorers[i].planTurns = e.param0;
+                else explorers[i].lightTurns = e.param0;
+            }
+        }
+        if (explorerCount > 0) {
+            explorers[0].planTurns  = max<int>(explorers[0].planTurns, planningDuration);
+            explorers[0].lightTurns = max<int>(explorers[0].lightTurns, lightingDuration);
+        }
     }
 
     bool operator<(const Node& node) const {
@@ -99,55 +253,96 @@ int myX, myY, myID, mySanity;
 int planningDuration, lightingDuration;
 
 //
-// 評価関数周り
+//  ユーティリティ
 //
-struct Evaluator {
-    Node *n;
-    int score[MAX_WIDTH][MAX_HEIGHT];
+bool isInside(int x, int y) {
+    return 0 <= x and x < width and 0 <= y and y < height;
+}
 
-    Evaluator(Node *n) : n(n) {}
+//
+// 迷路の距離表
+// 迷路は最初の入力から変わらないので、壁でないマスに番号を振り、全てのマスの組の最短距離と、
+// 最短路の最初の1歩の向きを1ターン目に求めておく。以降の距離・経路の問い合わせは表を引くだけになる。
+// (24x20の迷路でも壁でないマスからの幅優先探索を1回ずつするだけなので、数ms以内に終わる)
+//
+const int MAX_CELLS = MAX_WIDTH * MAX_HEIGHT;
+const uint8_t UNREACHABLE = 255;    // 距離表で、たどり着けない組
+const int NO_STEP = 4;              // 最初の1歩の表で、同じマスかたどり着けない組
 
-    int evaluate() {
-        return 0;
-    }
-    void setNode(Node *n) {
-        this->n = n;
-        for (int x = 0; x < width; x++) {
-            for (int y = 0; y < height; y++) {
-                score[x][y] = 0;
+const int DX[] = {1, 0, -1, 0},
+          DY[] = {0, 1, 0, -1};
+
+int cellCount;
+int cellIndex[MAX_WIDTH][MAX_HEIGHT];   // 壁なら-1
+int cellX[MAX_CELLS], cellY[MAX_CELLS];
+vector<uint8_t> distanceTable;          // [from * cellCount + to]
+vector<uint8_t> firstStepTable;         // [from * cellCount + to]。DX, DYの添字かNO_STEP
+
+void buildDistanceTable() {
+    cellCount = 0;
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            if (maze[x][y] & WALL) {
+                cellIndex[x][y] = -1;
+                continue;
             }
+            cellIndex[x][y]  = cellCount;
+            cellX[cellCount] = x;
+            cellY[cellCount] = y;
+            cellCount++;
         }
     }
-};
 
-//
-// シミュレータ周り
-//
-struct Simulator {
-    Node *n;
+    distanceTable.assign(cellCount * cellCount, UNREACHABLE);
+    firstStepTable.assign(cellCount * cellCount, NO_STEP);
 
-    Simulator(Node *n) : n(n) {}
+    // 始点ごとに幅優先探索し、最初の1歩の向きは親から受け継ぐ
+    static int queue[MAX_CELLS];
+    for (int from = 0; from < cellCount; from++) {
+        uint8_t* dist = &distanceTable[from * cellCount];
+        uint8_t* step = &firstStepTable[from * cellCount];
+        int head = 0,
+            tail = 0;
+        dist[from] = 0;
+        queue[tail++] = from;
 
-    Node simulateRandom() {
-    }
-    void setNode(Node *n) {
-        this->n = n;
+        while (head < tail) {
+            int c = queue[head++];
+            // 255はUNREACHABLEと区別できないので、それより遠い組は254のままにする
+            uint8_t d = min(dist[c] + 1, UNREACHABLE - 1);
+            for (int i = 0; i < 4; i++) {
+                int nx = cellX[c] + DX[i],
+                    ny = cellY[c] + DY[i];
+                if (!isInside(nx, ny) or cellIndex[nx][ny] < 0) continue;
+                int next = cellIndex[nx][ny];
+                if (dist[next] != UNREACHABLE) continue;
+                dist[next] = d;
+                step[next] = (c == from) ? i : step[c];
+                queue[tail++] = next;
+            }
+        }
     }
-};
+}
 
-//
-//  ユーティリティ
-//
-bool isInside(int x, int y) {
-    return 0 <= x and x < width and 0 <= y and y < height;
+// 壁の中を指定したときは、マンハッタン距離で代用する
+int calcDistance(int x1, int y1, int x2, int y2) {
+    int from = cellIndex[x1][y1],
+        to   = cellIndex[x2][y2];
+    if (from < 0 or to < 0) return abs(x1 - x2) + abs(y1 - y2);
+    uint8_t d = distanceTable[from * cellCount + to];
+    return d == UNREACHABLE ? INF : d;
 }
 
 int calcDistance(Entity& e1, Entity& e2) {
-    return abs(e1.x - e2.x) + abs(e1.y - e2.y);
+    return calcDistance(e1.x, e1.y, e2.x, e2.y);
 }
 
-int calcDistance(int x1, int y1, int x2, int y2) {
-    return abs(x1 - x2) + abs(y1 - y2);
+// (x1, y1)から(x2, y2)へ最短路で向かうときの最初の1歩の向き。動かないかたどり着けないならNO_STEP
+int firstStep(int x1, int y1, int x2, int y2) {
+    int from = cellIndex[x1][y1],
+        to   = cellIndex[x2][y2];
+    if (from < 0 or to < 0) return NO_STEP;
+    return firstStepTable[from * cellCount + to];
 }
 
 void updateState() {
@@ -155,35 +350,232 @@ void updateState() {
     lightingDuration = max(0, lightingDuration - 1);
 }
 
-void updateState(Node* n) {
-    n->planningDuration = max(0, n->planningDuration - 1);
-    n->lightingDuration = max(0, n->lightingDuration - 1);
-}
+// 標準入力をread()でまとめて読み込み、数値と単語を自前で解析する
+struct Reader {
+    static const int BUFFER_SIZE = (1 << 16);
 
-bool hasExplorer(Map& map, int x, int y) {
-    return map[x][y] & EXPLORER;
-}
+    char buffer[BUFFER_SIZE];
+    int pos = 0;
+    int len = 0;
+    bool eof = false;       // read()がこれ以上データを返さない
+    bool failed = false;    // 入力が尽きた状態で読もうとした
 
-bool hasWanderer(Map& map, int x, int y) {
-    return map[x][y] & WANDERER;
-}
+    Timer arrival;          // このターンの入力の最初の1バイトが届いた時刻
+    bool waiting = true;    // 次のターンの入力がまだ届いていない
+
+    // 手元のデータを入力として使う (ベンチマーク用)
+    void load(const char* data, int size) {
+        assert(size <= BUFFER_SIZE);
+        memcpy(buffer, data, size);
+        pos = 0;
+        len = size;
+        eof = true;
+        failed = false;
+        arrival.reset();
+        waiting = false;
+    }
+
+    // 出力を終えたら呼ぶ。次に届いたデータの時刻をそのターンの開始とする
+    void nextTurn() {
+        while (pos < len and buffer[pos] <= ' ') pos++;
+        waiting = (pos == len);
+        if (!waiting) arrival.reset();  // 既に次の入力が届いている
+    }
+
+    bool fill() {
+        if (eof) return false;
+        ssize_t n = read(0, buffer, BUFFER_SIZE);
+        if (n <= 0) {
+            eof = true;
+            return false;
+        }
+        pos = 0;
+        len = n;
+        if (waiting) {
+            arrival.reset();
+            waiting = false;
+        }
+        return true;
+    }
+
+    bool hasChar() {
+        return pos < len or fill();
+    }
+
+    // 空白を読み飛ばす。読める文字がなければfailedを立てる
+    bool skipSpaces() {
+        while (hasChar() and buffer[pos] <= ' ') pos++;
+        if (!hasChar()) {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    int readInt() {
+        if (!skipSpaces()) return 0;
+
+        bool negative = (buffer[pos] == '-');
+        if (negative) pos++;
+
+        int value = 0;
+        while (hasChar() and '0' <= buffer[pos] and buffer[pos] <= '9') {
+            value = value * 10 + (buffer[pos++] - '0');
+        }
+        return negative ? -value : value;
+    }
+
+    // 空白までをtokenに書き込み、長さを返す (capacity - 1文字を超える分は捨てる)
+    int readToken(char* token, int capacity) {
+        int length = 0;
+        if (skipSpaces()) {
+            while (hasChar() and buffer[pos] > ' ') {
+                if (length + 1 < capacity) token[length++] = buffer[pos];
+                pos++;
+            }
+        }
+        token[length] = '\0';
+        return length;
+    }
+};
+
+Reader reader;
+
+// ターンの持ち時間の管理。時計は入力の最初の1バイトが届いたときから進めるので、
+// 入力の読み込みや前処理にかかった時間も持ち時間に含まれる。
+// 探索ループからはisOver()を毎回呼んでよい (時計を見るのはCHECK_INTERVAL回に1回だけ)。
+// フェーズごとに、打ち切るまでにisOver()を何回呼んだかを記録しておく。リプレイではその回数をreplay()で
+// 渡すと、時計を見ずにちょうど同じ回数で打ち切るので、探索が本番と同じところで止まる。
+struct TimeManager {
+    static const int CHECK_INTERVAL = 16;
+    static const int MAX_PHASES     = 8;    // 1ターンのフェーズ数の上限 (超えた分は最後のフェーズとして扱う)
+
+    long long firstTurnBudget;  // [us]
+    long long turnBudget;       // [us]
+
+    Timer timer;
+    long long budget;
+    long long phaseEnd;     // 今のフェーズの期限 (ターン開始からの経過時間 [us])
+    int calls = 0;
+    bool over = false;
+
+    int phase = 0;
+    int work[MAX_PHASES];   // フェーズごとの、打ち切ったときのcalls (最後まで打ち切らなかったフェーズは-1)
+    bool replaying = false;
+
+    TimeManager(long long firstTurnBudget, long long turnBudget) :
+        firstTurnBudget(firstTurnBudget), turnBudget(turnBudget),
+        budget(firstTurnBudget), phaseEnd(firstTurnBudget) {}
 
-bool hasSlasher(Map& map, int x, int y) {
-    return map[x][y] & SLASHER;
+    void startTurn(const Timer& arrival, bool firstTurn) {
+        timer  = arrival;
+        budget = firstTurn ? firstTurnBudget : turnBudget;
+        phase  = -1;
+        beginPhase(1.0);
+    }
+
+    // ここから持ち時間のratioの割合 (ターン開始から数える) までを今のフェーズに使う
+    void beginPhase(double ratio) {
+        if (phase + 1 < MAX_PHASES) phase++;
+        phaseEnd = (long long)(budget * ratio);
+        calls    = 0;
+        if (!replaying) work[phase] = timer.elapsedMicros() >= phaseEnd ? 0 : -1;
+        over = work[phase] == 0;
+    }
+
+    long long elapsedMicros() const {
+        return timer.elapsedMicros();
+    }
+
+    bool isOver() {
+        if (!over) {
+            if (!replaying and (calls + 1) % CHECK_INTERVAL == 0 and timer.elapsedMicros() >= phaseEnd) {
+                work[phase] = calls;
+            }
+            over = calls++ == work[phase];
+        }
+        return over;
+    }
+
+    // このターンのフェーズごとの記録 (リプレイログに書き出す)
+    vector<int> record() const {
+        return vector<int>(work, work + phase + 1);
+    }
+
+    // 以降のターンを、記録した回数で打ち切るようにする (startTurnの前に呼ぶ)
+    void replay(const vector<int>& record) {
+        replaying = true;
+        for (int i = 0; i < MAX_PHASES; i++) work[i] = i < (int)record.size() ? record[i] : -1;
+    }
+};
+
+// 1ターン目は1000ms、それ以降は50msの制限に対して余裕を持たせる
+TimeManager timeManager(900 * 1000, 45 * 1000);
+
+// 環境変数BOT_SEEDがあればそれをシードにする (同じ手を再現するため)
+unsigned long long initialSeed() {
+    const char* env = getenv("BOT_SEED");
+    if (env != nullptr) return strtoull(env, nullptr, 10);
+    random_device rnd;
+    return rnd();
 }
 
-bool hasWall(Map& map, int x, int y) {
-    return map[x][y] & WALL;
+// PCG32 (64bitの線形合同法の状態を、xorshiftと回転で32bitに縮めて出力する)。
+// 状態が16バイトで呼び出しはインライン展開されるので、mt19937よりずっと軽い
+struct PCG32 {
+    uint64_t state;
+    uint64_t inc;
+
+    explicit PCG32(uint64_t seed, uint64_t stream = 0) {
+        state = 0;
+        inc   = (stream << 1) | 1;
+        next();
+        state += seed;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        uint32_t xorshifted = ((old >> 18) ^ old) >> 27;
+        uint32_t rot        = old >> 59;
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+
+    // [0, n)の一様な整数。剰余の代わりに掛け算の上位32bitを使い (Lemireの方法)、
+    // 偏りが出る下位の範囲に入ったときだけ引き直す
+    uint32_t bounded(uint32_t n) {
+        uint64_t m   = (uint64_t)next() * n;
+        uint32_t low = (uint32_t)m;
+        if (low < n) {
+            uint32_t threshold = -n % n;
+            while (low < threshold) {
+                m   = (uint64_t)next() * n;
+                low = (uint32_t)m;
+            }
+        }
+        return m >> 32;
+    }
+};
+
+unsigned long long seed = initialSeed();
+thread_local PCG32 rng(seed);   // スレッドごとに独立した状態を持つ
+
+// 呼び出したスレッドの乱数を初期化する (別のスレッドではstreamを変えると系列が重ならない)
+void setSeed(unsigned long long s, uint64_t stream = 0) {
+    seed = s;
+    rng  = PCG32(s, stream);
 }
 
-bool hasSpawn(Map& map, int x, int y) {
-    return map[x][y] & SPAWN;
+// ターンの初めに乱数を初期化し直す。ターンごとの乱数列がシードとターン番号だけで決まるので、
+// リプレイで途中のターンを1つだけ再現できる
+void seedTurn(int turn) {
+    rng = PCG32(seed ^ turn);
 }
 
-int randInt() {
-    static random_device rnd;
-    static mt19937 mt(rnd());
-    return mt();
+// n未満の非負整数をランダムに生成する
+int randInt(int n) {
+    return rng.bounded(n);
 }
 
 //
@@ -191,118 +583,583 @@ int randInt() {
 //
 
 void inputGameConstant() {
-    cin >> width; cin.ignore();
-
-    cin >> height; cin.ignore();
+    width  = reader.readInt();
+    height = reader.readInt();
 
     for (int i = 0; i < height; i++) {
-        string line;
-        getline(cin, line);
-
-        map<char, int> m = {{'.', BLANK}, {'w', WALL}, {'#', SPAWN}};
+        char line[MAX_WIDTH + 1];
+        reader.readToken(line, sizeof(line));
 
+        // '#'が壁、'w'がWandererの出現地点。それ以外 ('.'やシェルターの'U') は通れるマス
         for (int j = 0; j < width; j++) {
-            maze[j][i] |= m[line[j]];
+            if (line[j] == '#') maze[j][i] |= WALL;
+            else if (line[j] == 'w') maze[j][i] |= SPAWN;
         }
     }
+    buildDistanceTable();
 
-    cin >> sanityLossLonely >> sanityLossGroup >> wandererSpawnTime >> wandererLifeTime; cin.ignore();
+    sanityLossLonely  = reader.readInt();
+    sanityLossGroup   = reader.readInt();
+    wandererSpawnTime = reader.readInt();
+    wandererLifeTime  = reader.readInt();
 }
 
+void setPlayer(Entity& me);
+
 vector<Entity> inputEntities() {
-    int entityCount;
-    cin >> entityCount; cin.ignore();
+    int entityCount = reader.readInt();
 
     vector<Entity> entities;
+    entities.reserve(entityCount);
 
     for (int i = 0; i < entityCount; i++) {
-        string entityType;
-        int id;
-        int x;
-        int y;
-        int param0;
-        int param1;
-        int param2;
+        char token[16];     // 最長の"EFFECT_SHELTER"でも収まる
+        reader.readToken(token, sizeof(token));
 
-        cin >> entityType >> id >> x >> y >> param0 >> param1 >> param2; cin.ignore();
+        EntityType entityType = parseEntityType(token);
+        int id     = reader.readInt();
+        int x      = reader.readInt();
+        int y      = reader.readInt();
+        int param0 = reader.readInt();
+        int param1 = reader.readInt();
+        int param2 = reader.readInt();
 
         entities.emplace_back(entityType, id, x, y, param0, param1, param2);
-
-        if (i == 0) {
-            myID     = id;
-            myX      = x;
-            myY      = y;
-            mySanity = param0;
-        }
     }
+    if (!entities.empty()) setPlayer(entities[0]);
     return entities;
 }
 
-void execNode(Node *n) {
-    cout << n->output << endl;
+// 最初のentityが自分のExplorer
+void setPlayer(Entity& me) {
+    myID     = me.id;
+    myX      = me.x;
+    myY      = me.y;
+    mySanity = me.param0;
+}
 
-    if (n->output == "PLAN") {
+// 出力した行動による状態の変化を反映する
+void applyOutput(const string& output) {
+    if (output == "PLAN") {
         planningDuration = 5;
-    } else if (n->output == "LIGHT") {
+    } else if (output == "LIGHT") {
         lightingDuration = 3;
     }
     updateState();
 }
 
+void execAction(const Action& action) {
+    string output = toString(action);
+    cout << output << endl;
+    applyOutput(output);
+}
+
+//
+// シミュレータ周り
+// 自分の行動を1つ決めて1ターン進める。他のExplorerはその場で待つものとする。
+// ルールの細部は次のように扱っている:
+// * Wandererは出現してから寿命が尽きるまで、最も近い (LIGHTを使っているExplorerまでは距離を半分とみなす)
+//   Explorerに向かって1歩ずつ進み、Explorerと同じマスに入るとそこにいる全員のsanityを20減らして消える
+// * Slasherは出現後、縦横に壁を挟まず見えるExplorerを見つけると2ターン狙いを定め、最後に見た位置へ飛び込んで
+//   そこにいる全員のsanityを20減らし、6ターン動けなくなる
+// * 2マス以内に他のExplorerがいればsanityはsanityLossGroup、いなければsanityLossLonely減る
+// * PLANの効果が残っているExplorerの2マス以内にいるExplorer (本人を含む) はsanityが3回復する (250まで)
+//
+const int HIT_DAMAGE     = 20;
+const int SANITY_MAX     = 250;
+const int PLAN_DURATION  = 5;
+const int LIGHT_DURATION = 3;
+const int STALK_DURATION = 2;
+const int STUN_DURATION  = 6;
+const int GROUP_RANGE    = 2;
+const int PLAN_RANGE     = 2;
+
+int manhattan(int x1, int y1, int x2, int y2) {
+    return abs(x1 - x2) + abs(y1 - y2);
+}
+
+// 自分が選べる行動をactionsに書き込み、その数を返す
+int listActions(const Node& node, Action* actions) {
+    int count = 0;
+    actions[count++] = Action(ACTION_WAIT);
+
+    const Explorer& me = node.explorers[0];
+    if (node.explorerCount == 0 or me.sanity <= 0) return count;
+
+    for (int i = 0; i < 4; i++) {
+        int nx = me.x + DX[i],
+            ny = me.y + DY[i];
+        if (isInside(nx, ny) and cellIndex[nx][ny] >= 0) actions[count++] = Action(ACTION_MOVE, nx, ny);
+    }
+    if (me.plans > 0 and me.planTurns == 0) actions[count++] = Action(ACTION_PLAN);
+    if (me.lights > 0 and me.lightTurns == 0) actions[count++] = Action(ACTION_LIGHT);
+    return count;
+}
+
+struct Simulator {
+    Node *n;
+
+    Simulator(Node *n) : n(n) {}
+
+    // nを自分の行動actionで1ターン進める
+    void step(const Action& action) {
+        Explorer& me = n->explorers[0];
+        if (n->explorerCount > 0 and me.sanity > 0) {
+            if (action.type == ACTION_MOVE) {
+                me.x = action.x;
+                me.y = action.y;
+            } else if (action.type == ACTION_PLAN) {
+                me.plans--;
+                me.planTurns = PLAN_DURATION;
+            } else if (action.type == ACTION_LIGHT) {
+                me.lights--;
+                me.lightTurns = LIGHT_DURATION;
+            }
+        }
+
+        for (int i = 0; i < n->minionCount; i++) {
+            bool alive = (n->minions[i].type == TYPE_WANDERER) ? stepWanderer(n->minions[i]) : stepSlasher(n->minions[i]);
+            if (!alive) n->minions[i--] = n->minions[--n->minionCount];
+        }
+
+        updateSanity();
+    }
+
+    // 狙うExplorerの番号。いなければ-1
+    int nearestExplorer(int x, int y) const {
+        int best = -1, bestDistance = INF;
+        for (int i = 0; i < n->explorerCount; i++) {
+            const Explorer& e = n->explorers[i];
+            if (e.sanity <= 0) continue;
+            int d = calcDistance(x, y, e.x, e.y);
+            if (e.lightTurns > 0) d /= 2;
+            if (d < bestDistance) {
+                best         = i;
+                bestDistance = d;
+            }
+        }
+        return best;
+    }
+
+    // 縦横に壁を挟まず見えるExplorerのうち、最も近いものの番号。いなければ-1
+    int visibleExplorer(int x, int y) const {
+        int best = -1, bestDistance = INF;
+        for (int i = 0; i < n->explorerCount; i++) {
+            const Explorer& e = n->explorers[i];
+            if (e.sanity <= 0 or (e.x != x and e.y != y)) continue;
+
+            int sx = (e.x > x) - (e.x < x),
+                sy = (e.y > y) - (e.y < y),
+                cx = x,
+                cy = y;
+            while ((cx != e.x or cy != e.y) and cellIndex[cx][cy] >= 0) {
+                cx += sx;
+                cy += sy;
+            }
+            if (cellIndex[cx][cy] < 0) continue;
+
+            int d = manhattan(x, y, e.x, e.y);
+            if (d < bestDistance) {
+                best         = i;
+                bestDistance = d;
+            }
+        }
+        return best;
+    }
+
+    // (x, y)にいる全員のsanityを減らし、誰かいたらtrueを返す
+    bool hit(int x, int y) {
+        bool hitAny = false;
+        for (int i = 0; i < n->explorerCount; i++) {
+            Explorer& e = n->explorers[i];
+            if (e.sanity <= 0 or e.x != x or e.y != y) continue;
+            e.sanity -= HIT_DAMAGE;
+            hitAny = true;
+        }
+        return hitAny;
+    }
+
+    // Wandererを1ターン進める。消えたらfalseを返す
+    bool stepWanderer(Minion& m) {
+        if (m.state == STATE_SPAWNING) {
+            if (--m.timer <= 0) {
+                m.state = STATE_WANDERING;
+                m.timer = wandererLifeTime;
+            }
+            return true;
+        }
+        if (--m.timer <= 0) return false;
+
+        int target = nearestExplorer(m.x, m.y);
+        if (target >= 0) {
+            int dir = firstStep(m.x, m.y, n->explorers[target].x, n->explorers[target].y);
+            if (dir != NO_STEP) {
+                m.x += DX[dir];
+                m.y += DY[dir];
+            }
+        }
+        return !hit(m.x, m.y);
+    }
+
+    // Slasherを1ターン進める (Slasherは消えない)
+    bool stepSlasher(Minion& m) {
+        switch (m.state) {
+        case STATE_SPAWNING:
+        case STATE_STUNNED:
+            if (--m.timer <= 0) m.state = STATE_WANDERING;
+            break;
+        case STATE_WANDERING:
+        case STATE_STALKING: {
+            int target = visibleExplorer(m.x, m.y);
+            if (target >= 0) {
+                if (m.state == STATE_WANDERING) {
+                    m.state = STATE_STALKING;
+                    m.timer = STALK_DURATION;
+                }
+                m.targetX = n->explorers[target].x;
+                m.targetY = n->explorers[target].y;
+            }
+            if (m.state == STATE_STALKING and --m.timer <= 0) m.state = STATE_RUSHING;
+            break;
+        }
+        case STATE_RUSHING:
+            m.x = m.targetX;
+            m.y = m.targetY;
+            hit(m.x, m.y);
+            m.state = STATE_STUNNED;
+            m.timer = STUN_DURATION;
+            break;
+        }
+        return true;
+    }
+
+    void updateSanity() {
+        Explorer* es = n->explorers;
+        int count = n->explorerCount;
+
+        for (int i = 0; i < count; i++) {
+            if (es[i].sanity <= 0) continue;
+            bool grouped = false;
+            for (int j = 0; j < count and !grouped; j++) {
+                grouped = (j != i and es[j].sanity > 0 and manhattan(es[i].x, es[i].y, es[j].x, es[j].y) <= GROUP_RANGE);
+            }
+            es[i].sanity -= grouped ? sanityLossGroup : sanityLossLonely;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (es[i].planTurns > 0) {
+                for (int j = 0; j < count; j++) {
+                    if (es[j].sanity <= 0 or manhattan(es[i].x, es[i].y, es[j].x, es[j].y) > PLAN_RANGE) continue;
+                    es[j].sanity = min<int>(es[j].sanity + 3, SANITY_MAX);
+                }
+                es[i].planTurns--;
+            }
+            if (es[i].lightTurns > 0) es[i].lightTurns--;
+        }
+    }
+};
+
+//
+// 評価関数周り
+//
+const int SAFE_DISTANCE = 8;    // Wandererがこれより遠ければ距離は評価しない
+
+struct Evaluator {
+    Node *n;
+
+    Evaluator(Node *n) : n(n) {}
+
+    // sanityが最優先。同じならWandererから遠く、他のExplorerの近くにいて、PLAN・LIGHTを温存している方が良い
+    int evaluate() {
+        Stats::count(Stats::EVALUATIONS);
+        const Explorer& me = n->explorers[0];
+        if (n->explorerCount == 0 or me.sanity <= 0) return -INF;
+
+        int nearest = SAFE_DISTANCE;
+        for (int i = 0; i < n->minionCount; i++) {
+            const Minion& m = n->minions[i];
+            if (m.type == TYPE_WANDERER and m.state == STATE_WANDERING) {
+                nearest = min(nearest, calcDistance(m.x, m.y, me.x, me.y));
+            }
+        }
+
+        bool grouped = false;
+        for (int i = 1; i < n->explorerCount and !grouped; i++) {
+            const Explorer& e = n->explorers[i];
+            grouped = (e.sanity > 0 and manhattan(e.x, e.y, me.x, me.y) <= GROUP_RANGE);
+        }
+
+        return me.sanity * 100 + nearest * 20 + grouped * 30 + (me.plans + me.lights) * 5;
+    }
+};
+
 //
 // アルゴリズム部分
+// ビームサーチ。候補のNodeは2つの層の領域を交互に使い回し、親子関係は32bitの記録番号で別の表に残す。
+// 上位BEAM_WIDTH個は (評価値, 候補の番号) の組に対するnth_elementで選び、Nodeそのものは並べ替えない。
+// 領域は最初に1度だけ確保するので、探索中のメモリ確保はない。
 //
-const int SEARCH_DEPTH = 100;
-const int BEAM_WIDTH   = 20;
+const int SEARCH_DEPTH   = 100;     // 持ち時間が残っていればここまで読む
+const int BEAM_WIDTH     = 20;
+const int MAX_ACTIONS    = 7;       // WAIT, MOVE x4, PLAN, LIGHT
+const int MAX_CANDIDATES = BEAM_WIDTH * MAX_ACTIONS;
 
-// 参考:
-Node beamSearch(Node *now) {
-    priority_queue<Node> nexts;
-    nexts.push(*now);
+struct BeamSearch {
+    vector<Node> layers[2];             // 今の深さのビームと、その遷移先の候補
+    vector<pair<int, int>> order;       // (評価値, 候補の番号)
+    int beam[BEAM_WIDTH];               // ビームに残った候補の番号
+    int beamSize;
 
-    // nextsに突っ込まれたデータをすべて保存するものが必要
-    static Node history[SEARCH_DEPTH * BEAM_WIDTH];
+    // 記録番号ごとの親の記録番号と、親からの行動 (0番は根)
+    vector<uint32_t> parents;
+    vector<Action> actions;
+    uint32_t traceCount;
 
-    for (int depth = 0; depth < SEARCH_DEPTH; depth++) {
-        priority_queue<Node> temp;  // BEAM_WIDTH個しか要素が入らない
+    BeamSearch() {
+        for (auto& layer : layers) layer.resize(MAX_CANDIDATES);
+        order.resize(MAX_CANDIDATES);
+        parents.resize(SEARCH_DEPTH * MAX_CANDIDATES + 1);
+        actions.resize(SEARCH_DEPTH * MAX_CANDIDATES + 1);
+    }
 
-        for (int i = 0; i < BEAM_WIDTH and !nexts.empty(); i++) {
-            Node node = nexts.top(); nexts.pop();
-            temp.push(node);
+    // rootから読んで、最初に取るべき行動を返す
+    Action search(const Node& root) {
+        Stats::Scope scope(Stats::SEARCH);
+
+        layers[0][0]       = root;
+        layers[0][0].trace = 0;
+        beam[0]    = 0;
+        beamSize   = 1;
+        traceCount = 1;
+
+        int depth = 0;
+        for (; depth < SEARCH_DEPTH; depth++) {
+            vector<Node>& current = layers[depth & 1];
+            vector<Node>& next    = layers[(depth + 1) & 1];
+            int count = expand(current, next);
+            if (count < 0) break;   // 時間切れ。この深さの候補は捨てる
+
+            for (int i = 0; i < count; i++) order[i] = make_pair(next[i].score, i);
+            int width = min(count, BEAM_WIDTH);
+            if (count > BEAM_WIDTH) {
+                nth_element(order.begin(), order.begin() + BEAM_WIDTH, order.begin() + count, greater<pair<int, int>>());
+            }
+            for (int i = 0; i < width; i++) beam[i] = order[i].second;
+            beamSize = width;
         }
 
-        // nextsにはtempからの遷移先がすべて入る
-        nexts = priority_queue<Node>();
+        // 1手も読めなかったときは待つ
+        if (depth == 0) return Action(ACTION_WAIT);
+
+        const vector<Node>& last = layers[depth & 1];
+        int best = beam[0];
+        for (int i = 1; i < beamSize; i++) {
+            if (last[beam[i]].score > last[best].score) best = beam[i];
+        }
+
+        uint32_t trace = last[best].trace;
+        while (parents[trace] != 0) trace = parents[trace];
+        return actions[trace];
+    }
+
+    // ビームの各Nodeから全ての行動で1ターン進めた候補をnextに書き、その数を返す。時間切れなら-1
+    int expand(const vector<Node>& current, vector<Node>& next) {
+        int count = 0;
+        for (int b = 0; b < beamSize; b++) {
+            if (timeManager.isOver()) return -1;
 
-        while (!temp.empty()) {
-            Node node = temp.top(); temp.pop();
+            const Node& node = current[beam[b]];
+            Action moves[MAX_ACTIONS];
+            int moveCount = listActions(node, moves);
+            for (int i = 0; i < moveCount; i++) {
+                Node& child = next[count++];
+                child = node;
+                Simulator(&child).step(moves[i]);
+                child.score = Evaluator(&child).evaluate();
 
-            // 遷移先
-            node.output = "WAIT";
-            node.parent = now;
-            nexts.push(node);
+                child.trace         = traceCount;
+                parents[traceCount] = node.trace;
+                actions[traceCount] = moves[i];
+                traceCount++;
+                Stats::count(Stats::NODES);
+            }
         }
+        return count;
+    }
+};
+
+BeamSearch beamSearch;
+
+//
+// リプレイログ
+// 環境変数BOT_REPLAYにファイル名を指定すると、シード・迷路などの定数・毎ターンのentity・出力をバイナリで書き出す。
+// 出力の記録には、フェーズごとに探索を打ち切ったところ (TimeManager::record) も含める。
+// ./main --replay FILE で記録した入力を、同じ打ち切り位置でもう一度思考させ、ターンごとの時間と出力の違いを表示する。
+//
+const char REPLAY_MAGIC[4] = {'K', 'R', 'P', '4'};
+const unsigned char REPLAY_CONSTANTS = 0;
+const unsigned char REPLAY_INPUT     = 1;
+const unsigned char REPLAY_OUTPUT    = 2;   // 打ち切り位置の個数, 打ち切り位置..., 出力の文字列
+
+FILE* replayLog = nullptr;
+
+void openReplayLog() {
+    const char* path = getenv("BOT_REPLAY");
+    if (path == nullptr or (replayLog = fopen(path, "wb")) == nullptr) return;
+    fwrite(REPLAY_MAGIC, 1, 4, replayLog);
+    fwrite(&seed, sizeof(seed), 1, replayLog);
+}
+
+void writeReplay(unsigned char kind, const string& data) {
+    if (replayLog == nullptr) return;
+    unsigned size = data.size();
+    fwrite(&kind, 1, 1, replayLog);
+    fwrite(&size, sizeof(size), 1, replayLog);
+    fwrite(data.data(), 1, size, replayLog);
+    if (kind == REPLAY_OUTPUT) fflush(replayLog);
+}
+
+bool readReplay(FILE* in, unsigned char& kind, string& data) {
+    unsigned size;
+    if (fread(&kind, 1, 1, in) != 1 or fread(&size, sizeof(size), 1, in) != 1) return false;
+    data.resize(size);
+    return fread(&data[0], 1, size, in) == size;
+}
+
+void putInt(string& data, int value) {
+    data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+int getInt(const char*& p) {
+    int value;
+    memcpy(&value, p, sizeof(value));
+    p += sizeof(value);
+    return value;
+}
+
+string serializeConstants() {
+    string data;
+    for (int value : {width, height, sanityLossLonely, sanityLossGroup, wandererSpawnTime, wandererLifeTime}) {
+        putInt(data, value);
+    }
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) putInt(data, maze[x][y]);
     }
-    Node node = nexts.top(),
-         *cur = &node;
+    return data;
+}
+
+void deserializeConstants(const char* p) {
+    width             = getInt(p);
+    height            = getInt(p);
+    sanityLossLonely  = getInt(p);
+    sanityLossGroup   = getInt(p);
+    wandererSpawnTime = getInt(p);
+    wandererLifeTime  = getInt(p);
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) maze[x][y] = getInt(p);
+    }
+    buildDistanceTable();
+}
+
+string serializeOutput(const vector<int>& work, const string& output) {
+    string data;
+    putInt(data, work.size());
+    for (int value : work) putInt(data, value);
+    return data + output;
+}
 
-    while (cur->parent != now) {
-        cur = cur->parent;
+// entityごとに (種類, id, x, y, param0, param1, param2)
+string serializeEntities(vector<Entity>& entities) {
+    string data;
+    putInt(data, entities.size());
+    for (auto& e : entities) {
+        for (int value : {(int)e.entityType, e.id, e.x, e.y, e.param0, e.param1, e.param2}) putInt(data, value);
     }
-    return *cur;
+    return data;
 }
 
-int main() {
+vector<Entity> deserializeEntities(const char* p) {
+    vector<Entity> entities(getInt(p));
+    for (auto& e : entities) {
+        e.entityType = (EntityType)getInt(p);
+        e.id     = getInt(p);
+        e.x      = getInt(p);
+        e.y      = getInt(p);
+        e.param0 = getInt(p);
+        e.param1 = getInt(p);
+        e.param2 = getInt(p);
+    }
+    return entities;
+}
+
+int runReplay(const char* path) {
+    FILE* in = fopen(path, "rb");
+    char magic[4];
+    if (in == nullptr or fread(magic, 1, 4, in) != 4 or memcmp(magic, REPLAY_MAGIC, 4) != 0 or
+        fread(&seed, sizeof(seed), 1, in) != 1) {
+        cerr << "invalid replay file: " << path << endl;
+        return 1;
+    }
+    setSeed(seed);
+
+    unsigned char kind;
+    string data;
+    vector<Entity> entities;
+    int turn = 0;
+    while (readReplay(in, kind, data)) {
+        const char* p = data.data();
+        if (kind == REPLAY_CONSTANTS) {
+            deserializeConstants(p);
+        } else if (kind == REPLAY_INPUT) {
+            entities = deserializeEntities(p);
+            if (!entities.empty()) setPlayer(entities[0]);
+            turn++;
+        } else {
+            vector<int> work(getInt(p));
+            for (int& value : work) value = getInt(p);
+            string logged(p, data.data() + data.size());
+
+            Timer timer;
+            timeManager.replay(work);
+            timeManager.startTurn(timer, turn == 1);
+            seedTurn(turn);
+            Node node = Node(entities, planningDuration, lightingDuration);
+            string result = toString(beamSearch.search(node));
+            long long elapsed = timer.elapsedMicros();
+
+            printf("turn %d  %lld us  output: %s\n", turn, elapsed, result.c_str());
+            printf("turn %d  logged: %s%s\n", turn, logged.c_str(), logged == result ? "" : "  (differs)");
+            fflush(stdout);
+            applyOutput(logged);
+            Stats::flush(turn);
+        }
+    }
+    fclose(in);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 and string(argv[1]) == "--replay") {
+        return runReplay(argv[2]);
+    }
+    openReplayLog();
+
     inputGameConstant();
+    writeReplay(REPLAY_CONSTANTS, serializeConstants());
 
-    while (true) {
+    for (int turn = 1; ; turn++) {
         auto entities = inputEntities();
+        if (reader.failed) break;
+        timeManager.startTurn(reader.arrival, turn == 1);
+        writeReplay(REPLAY_INPUT, serializeEntities(entities));
 
-        Node node = Node(entities, planningDuration, lightingDuration),
-             ans  = beamSearch(&node);
-        execNode(&ans);
-
-        cerr << randInt() << endl;
+        seedTurn(turn);
+        Node node = Node(entities, planningDuration, lightingDuration);
+        Action ans = beamSearch.search(node);
+        writeReplay(REPLAY_OUTPUT, serializeOutput(timeManager.record(), toString(ans)));
+        execAction(ans);
+        reader.nextTurn();
+        Stats::flush(turn);
     }
 
 
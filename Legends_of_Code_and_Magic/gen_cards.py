@@ -0,0 +1,41 @@
+# creature.txtからmain.ccのカードテーブル (CardDB::cards) を生成する
+#   python3 gen_cards.py creature.txt main.cc
+import sys
+
+BEGIN = '    // ---- BEGIN GENERATED CARD TABLE (gen_cards.py) ----\n'
+END = '    // ---- END GENERATED CARD TABLE ----\n'
+
+types = {'creature': 0, 'itemGreen': 1, 'itemRed': 2, 'itemBlue': 3}
+
+def ability_mask(abilities):
+    mask = 0
+    for i, c in enumerate(abilities):
+        if c != '-':
+            mask |= 1 << i
+    return mask
+
+src, dst = sys.argv[1], sys.argv[2]
+
+data = []
+for line in open(src):
+    record = [token.strip() for token in line.split(';')]
+    if len(record) < 10:
+        continue
+    data.append(record)
+
+data.sort(key = lambda r: int(r[0]))
+
+lines = [BEGIN]
+lines.append('    static const int MAX_NUMBER = %d;\n' % max(int(r[0]) for r in data))
+lines.append('    static constexpr Data cards[] = {\n')
+for r in data:
+    # number, type, cost, attack, defense, abilities, myHealthChange, opponentHealthChange, cardDraw
+    values = [int(r[0]), types[r[2]], int(r[3]), int(r[4]), int(r[5]), ability_mask(r[6]),
+              int(r[7]), int(r[8]), int(r[9])]
+    lines.append('        { %s },  // %s\n' % (', '.join(map(str, values)), r[1]))
+lines.append('    };\n')
+lines.append(END)
+
+code = open(dst).read()
+begin, end = code.index(BEGIN), code.index(END) + len(END)
+open(dst, 'w').write(code[:begin] + ''.join(lines) + code[end:])
@@ -5,20 +5,94 @@
 #include <utility>
 #include <string>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
 #include <assert.h>
+#include <unistd.h>
 using namespace std;
 
 const int INF = (1 << 28);
 
+// PCG32とinitialSeed, setSeed, seedTurn, randIntはCode_of_Kutulu/main.ccからの写し (このファイルではnamespace Randomに入れ、
+// 括弧の書き方をこのファイルに合わせている)。直すときは向こうを直してから写す
 namespace Random
 {
-    static random_device rnd;
-    static mt19937 mt(rnd());
+    // 環境変数BOT_SEEDがあればそれをシードにする (同じ手を再現するため)
+    unsigned long long initialSeed()
+    {
+        const char* env = getenv("BOT_SEED");
+        if (env != nullptr) return strtoull(env, nullptr, 10);
+        random_device rnd;
+        return rnd();
+    }
+
+    // PCG32 (64bitの線形合同法の状態を、xorshiftと回転で32bitに縮めて出力する)。
+    // 状態が16バイトで呼び出しはインライン展開されるので、mt19937よりずっと軽い
+    struct PCG32
+    {
+        uint64_t state;
+        uint64_t inc;
+
+        explicit PCG32(uint64_t seed, uint64_t stream = 0)
+        {
+            state = 0;
+            inc = (stream << 1) | 1;
+            next();
+            state += seed;
+            next();
+        }
+
+        uint32_t next()
+        {
+            uint64_t old = state;
+            state = old * 6364136223846793005ULL + inc;
+            uint32_t xorshifted = ((old >> 18) ^ old) >> 27;
+            uint32_t rot = old >> 59;
+            return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+        }
+
+        // [0, n)の一様な整数。剰余の代わりに掛け算の上位32bitを使い (Lemireの方法)、
+        // 偏りが出る下位の範囲に入ったときだけ引き直す
+        uint32_t bounded(uint32_t n)
+        {
+            uint64_t m = (uint64_t)next() * n;
+            uint32_t low = (uint32_t)m;
+            if (low < n)
+            {
+                uint32_t threshold = -n % n;
+                while (low < threshold)
+                {
+                    m = (uint64_t)next() * n;
+                    low = (uint32_t)m;
+                }
+            }
+            return m >> 32;
+        }
+    };
+
+    static unsigned long long seed = initialSeed();
+    static thread_local PCG32 rng(seed);    // スレッドごとに独立した状態を持つ
 
-    // n未満の非負整数をランダムに返す
+    // 呼び出したスレッドの乱数を初期化する (別のスレッドではstreamを変えると系列が重ならない)
+    void setSeed(unsigned long long s, uint64_t stream = 0)
+    {
+        seed = s;
+        rng = PCG32(s, stream);
+    }
+
+    // ターンの初めに乱数を初期化し直す。ターンごとの乱数列がシードとターン番号だけで決まるので、
+    // リプレイで途中のターンを1つだけ再現できる
+    void seedTurn(int turn)
+    {
+        rng = PCG32(seed ^ turn);
+    }
+
+    // n未満の非負整数をランダムに生成する
     int randInt(int n)
     {
-        return mt() % n;
+        return rng.bounded(n);
     }
 
     // [a, b)に属する整数をランダムに返す
@@ -50,6 +124,294 @@ namespace Util
     }
 };
 
+// Timer / Reader / TimeManagerはCode_of_Kutulu/main.ccからの写し (括弧の書き方だけこのファイルに合わせている)。
+// 直すときは向こうを直してから写す
+struct Timer
+{
+    chrono::steady_clock::time_point start;
+
+    Timer() { reset(); }
+
+    void reset()
+    {
+        start = chrono::steady_clock::now();
+    }
+
+    // 経過時間 [us]
+    long long elapsedMicros() const
+    {
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+// 標準入力をread()でまとめて読み込み、数値と単語を自前で解析する
+struct Reader
+{
+    static const int BUFFER_SIZE = (1 << 16);
+
+    char buffer[BUFFER_SIZE];
+    int pos = 0;
+    int len = 0;
+    bool eof = false;       // read()がこれ以上データを返さない
+    bool failed = false;    // 入力が尽きた状態で読もうとした
+
+    Timer arrival;          // このターンの入力の最初の1バイトが届いた時刻
+    bool waiting = true;    // 次のターンの入力がまだ届いていない
+
+    // 手元のデータを入力として使う (ベンチマーク用)
+    void load(const char* data, int size)
+    {
+        assert(size <= BUFFER_SIZE);
+        memcpy(buffer, data, size);
+        pos = 0;
+        len = size;
+        eof = true;
+        failed = false;
+        arrival.reset();
+        waiting = false;
+    }
+
+    // 出力を終えたら呼ぶ。次に届いたデータの時刻をそのターンの開始とする
+    void nextTurn()
+    {
+        while (pos < len and buffer[pos] <= ' ') pos++;
+        waiting = (pos == len);
+        if (!waiting) arrival.reset();  // 既に次の入力が届いている
+    }
+
+    bool fill()
+    {
+        if (eof) return false;
+        ssize_t n = read(0, buffer, BUFFER_SIZE);
+        if (n <= 0)
+        {
+            eof = true;
+            return false;
+        }
+        pos = 0;
+        len = n;
+        if (waiting)
+        {
+            arrival.reset();
+            waiting = false;
+        }
+        return true;
+    }
+
+    bool hasChar()
+    {
+        return pos < len or fill();
+    }
+
+    // 空白を読み飛ばす。読める文字がなければfailedを立てる
+    bool skipSpaces()
+    {
+        while (hasChar() and buffer[pos] <= ' ') pos++;
+        if (!hasChar())
+        {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    int readInt()
+    {
+        if (!skipSpaces()) return 0;
+
+        bool negative = (buffer[pos] == '-');
+        if (negative) pos++;
+
+        int value = 0;
+        while (hasChar() and '0' <= buffer[pos] and buffer[pos] <= '9')
+        {
+            value = value * 10 + (buffer[pos++] - '0');
+        }
+        return negative ? -value : value;
+    }
+
+    // 空白までをtokenに書き込み、長さを返す (capacity - 1文字を超える分は捨てる)
+    int readToken(char* token, int capacity)
+    {
+        int length = 0;
+        if (skipSpaces())
+        {
+            while (hasChar() and buffer[pos] > ' ')
+            {
+                if (length + 1 < capacity) token[length++] = buffer[pos];
+                pos++;
+            }
+        }
+        token[length] = '\0';
+        return length;
+    }
+};
+
+Reader reader;
+
+// ターンの持ち時間の管理。時計は入力の最初の1バイトが届いたときから進めるので、
+// 入力の読み込みや前処理にかかった時間も持ち時間に含まれる。
+// 探索ループからはisOver()を毎回呼んでよい (時計を見るのはCHECK_INTERVAL回に1回だけ)。
+// フェーズごとに、打ち切るまでにisOver()を何回呼んだかを記録しておく。リプレイではその回数をreplay()で
+// 渡すと、時計を見ずにちょうど同じ回数で打ち切るので、探索が本番と同じところで止まる。
+struct TimeManager
+{
+    static const int CHECK_INTERVAL = 16;
+    static const int MAX_PHASES = 8;    // 1ターンのフェーズ数の上限 (超えた分は最後のフェーズとして扱う)
+
+    long long firstTurnBudget;  // [us]
+    long long turnBudget;       // [us]
+
+    Timer timer;
+    long long budget;
+    long long phaseEnd;     // 今のフェーズの期限 (ターン開始からの経過時間 [us])
+    int calls = 0;
+    bool over = false;
+
+    int phase = 0;
+    int work[MAX_PHASES];   // フェーズごとの、打ち切ったときのcalls (最後まで打ち切らなかったフェーズは-1)
+    bool replaying = false;
+
+    TimeManager(long long firstTurnBudget, long long turnBudget)
+        : firstTurnBudget(firstTurnBudget), turnBudget(turnBudget),
+          budget(firstTurnBudget), phaseEnd(firstTurnBudget) {}
+
+    void startTurn(const Timer& arrival, bool firstTurn)
+    {
+        timer = arrival;
+        budget = firstTurn ? firstTurnBudget : turnBudget;
+        phase = -1;
+        beginPhase(1.0);
+    }
+
+    // ここから持ち時間のratioの割合 (ターン開始から数える) までを今のフェーズに使う
+    void beginPhase(double ratio)
+    {
+        if (phase + 1 < MAX_PHASES) phase++;
+        phaseEnd = (long long)(budget * ratio);
+        calls = 0;
+        if (!replaying) work[phase] = timer.elapsedMicros() >= phaseEnd ? 0 : -1;
+        over = work[phase] == 0;
+    }
+
+    long long elapsedMicros() const
+    {
+        return timer.elapsedMicros();
+    }
+
+    bool isOver()
+    {
+        if (!over)
+        {
+            if (!replaying and (calls + 1) % CHECK_INTERVAL == 0 and timer.elapsedMicros() >= phaseEnd)
+            {
+                work[phase] = calls;
+            }
+            over = calls++ == work[phase];
+        }
+        return over;
+    }
+
+    // このターンのフェーズごとの記録 (リプレイログに書き出す)
+    vector<int> record() const
+    {
+        return vector<int>(work, work + phase + 1);
+    }
+
+    // 以降のターンを、記録した回数で打ち切るようにする (startTurnの前に呼ぶ)
+    void replay(const vector<int>& record)
+    {
+        replaying = true;
+        for (int i = 0; i < MAX_PHASES; i++) work[i] = i < (int)record.size() ? record[i] : -1;
+    }
+};
+
+// 1ターン目は1000ms、それ以降は100msの制限に対して余裕を持たせる
+TimeManager timeManager(900 * 1000, 85 * 1000);
+
+// 容量固定のvector。要素を内部配列に持つので、コピーがヒープ確保を伴わない
+template <class T, int CAPACITY>
+struct FixedVector
+{
+    T data[CAPACITY];
+    int count = 0;
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { count = 0; }
+    void push_back(const T& elt) { assert(count < CAPACITY); data[count++] = elt; }
+    void pop_back() { count--; }
+
+    T& operator[](int i) { return data[i]; }
+    const T& operator[](int i) const { return data[i]; }
+
+    T* begin() { return data; }
+    T* end() { return data + count; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + count; }
+};
+
+// ターンごとの計測。-DBOT_STATSを付けてコンパイルしたときだけ、フェーズごとの時間と
+// 展開ノード数・評価回数を数え、ターンの終わりに1行だけ標準エラー出力に書き出す。
+// 付けなければ中身のない関数と空の構造体になり、何も生成されない。
+namespace Stats
+{
+    enum Phase { DRAFT, LETHAL, GREEDY, SEARCH, PHASE_COUNT };
+    enum Counter { NODES, EVALUATIONS, PLAYOUTS, COUNTER_COUNT };
+
+#ifdef BOT_STATS
+    static const char* PHASE_NAMES[] = { "draft", "lethal", "greedy", "search" };
+    static const char* COUNTER_NAMES[] = { "nodes", "evals", "playouts" };
+
+    long long phaseMicros[PHASE_COUNT];
+    long long counters[COUNTER_COUNT];
+
+    inline void count(Counter counter, long long n = 1)
+    {
+        counters[counter] += n;
+    }
+
+    // 生存期間の時間をphaseに加算する
+    struct Scope
+    {
+        Phase phase;
+        Timer timer;
+
+        explicit Scope(Phase phase) : phase(phase) {}
+        ~Scope() { phaseMicros[phase] += timer.elapsedMicros(); }
+    };
+
+    void flush(int turn)
+    {
+        char line[256];
+        int len = snprintf(line, sizeof(line), "turn %d |", turn);
+        for (int i = 0; i < PHASE_COUNT; i++)
+        {
+            if (phaseMicros[i] > 0) len += snprintf(line + len, sizeof(line) - len, " %s %lldus", PHASE_NAMES[i], phaseMicros[i]);
+        }
+        len += snprintf(line + len, sizeof(line) - len, " |");
+        for (int i = 0; i < COUNTER_COUNT; i++)
+        {
+            len += snprintf(line + len, sizeof(line) - len, " %s %lld", COUNTER_NAMES[i], counters[i]);
+        }
+        fprintf(stderr, "%s\n", line);
+        fflush(stderr);
+
+        memset(phaseMicros, 0, sizeof(phaseMicros));
+        memset(counters, 0, sizeof(counters));
+    }
+#else
+    inline void count(Counter, long long = 1) {}
+
+    struct Scope
+    {
+        explicit Scope(Phase) {}
+    };
+
+    inline void flush(int) {}
+#endif
+};
+
 namespace GC
 {
     // location
@@ -70,117 +432,146 @@ namespace GC
     static const int GREEN_ITEM = 1;
     static const int RED_ITEM = 2;
     static const int BLUE_ITEM = 3;
+
+    // ability (abilities文字列 "BCDGLW" の位置に対応するビット)
+    static const int ABILITY_COUNT = 6;
+    static const int BREAKTHROUGH = (1 << 0);
+    static const int CHARGE       = (1 << 1);
+    static const int DRAIN        = (1 << 2);
+    static const int GUARD        = (1 << 3);
+    static const int LETHAL       = (1 << 4);
+    static const int WARD         = (1 << 5);
+
+    // 手札8枚 + 自分の場6体 + 相手の場6体
+    static const int MAX_CARDS = 20;
 };
 
 struct Card
 {
-    int number;
-    int id;
-    int location;   // 0: 自分の手札, 1: 自分の場, -1: 相手の場
-    int type;
-    int cost;
-    int attack;
-    int defense;
-    string abilities;   // ex) ---G--
-    int myHealthChange;
-    int opponentHealthChange;
-    int cardDraw;
+    short number;
+    short id;
+    signed char location;   // 0: 自分の手札, 1: 自分の場, -1: 相手の場
+    signed char type;
+    signed char cost;
+    unsigned char abilities;    // GC::BREAKTHROUGH などのビットマスク
+    short attack;
+    short defense;
+    short myHealthChange;
+    short opponentHealthChange;
+    signed char cardDraw;
     bool canUse;
 
-    Card() {}
+    Card() = default;
     Card(int number, int id, int location, int type, int cost, int attack,
-         int defense, string abilities, int myHealthChange, int opponentHealthChange,
+         int defense, int abilities, int myHealthChange, int opponentHealthChange,
          int cardDraw) :
-        number{number}, id{id}, location{location}, type{type}, cost{cost}, attack{attack},
-        defense{defense}, abilities{abilities}, myHealthChange{myHealthChange},
-        opponentHealthChange{opponentHealthChange}, cardDraw{cardDraw}, canUse{canUse}
+        number(number), id(id), location(location), type(type), cost(cost), abilities(abilities),
+        attack(attack), defense(defense), myHealthChange(myHealthChange),
+        opponentHealthChange(opponentHealthChange), cardDraw(cardDraw)
     {
         if (type == GC::CREATURE) canUse = (location == GC::MY_SIDE);
         else canUse = (type == GC::GREEN_ITEM);
     }
-    Card(const Card& card) : number{card.number}, id{card.id}, location{card.location},
-                             type{card.type}, cost{card.cost}, attack{card.attack}, defense{card.defense},
-                             abilities{card.abilities}, myHealthChange{card.myHealthChange},
-                             opponentHealthChange{card.opponentHealthChange}, cardDraw{card.cardDraw},
-                             canUse{card.canUse} {}
-    
+
+    // "BCDGLW" 形式の文字列をビットマスクに変換する
+    static int parseAbilities(const char* abilities)
+    {
+        int mask = 0;
+        for (int i = 0; i < GC::ABILITY_COUNT and abilities[i] != '\0'; i++)
+        {
+            if (abilities[i] != '-') mask |= (1 << i);
+        }
+        return mask;
+    }
+
     static Card input()
     {
-        int number, id, location, type, cost, attack, defense,
-            myHealthChange, opponentHealthChange, cardDraw;
-        string abilities;
+        int number = reader.readInt(),
+            id = reader.readInt(),
+            location = reader.readInt(),
+            type = reader.readInt(),
+            cost = reader.readInt(),
+            attack = reader.readInt(),
+            defense = reader.readInt();
+
+        char abilities[GC::ABILITY_COUNT + 2];
+        reader.readToken(abilities, sizeof(abilities));
 
-        cin >> number >> id >> location >> type >> cost >> attack >> defense >>
-               abilities >> myHealthChange >> opponentHealthChange >> cardDraw; cin.ignore();
+        int myHealthChange = reader.readInt(),
+            opponentHealthChange = reader.readInt(),
+            cardDraw = reader.readInt();
 
         return Card(number, id, location, type, cost, attack, defense,
-                    abilities, myHealthChange, opponentHealthChange, cardDraw);
+                    parseAbilities(abilities), myHealthChange, opponentHealthChange, cardDraw);
     }
 };
 
+// GameNodeのコピーを単純なメモリコピーで済ませるため、Cardはtrivially copyableに保つ
+static_assert(is_trivially_copyable<Card>::value, "Card must stay trivially copyable");
+
 bool hasBreakthroughAbility(const Card& card)
 {
-    return card.abilities[0] == 'B';
+    return card.abilities & GC::BREAKTHROUGH;
 }
 
 void addBreakthroughAbility(Card& card)
 {
-    card.abilities[0] = 'B';
+    card.abilities |= GC::BREAKTHROUGH;
 }
 
 bool hasChargeAbility(const Card& card)
 {
-    return card.abilities[1] == 'C';
+    return card.abilities & GC::CHARGE;
 }
 
 void addChargeAbility(Card& card)
 {
-    card.abilities[1] = 'C';
+    card.abilities |= GC::CHARGE;
 }
 
 bool hasDrainAbility(const Card& card)
 {
-    return card.abilities[2] == 'D';
+    return card.abilities & GC::DRAIN;
 }
 
 void addDrainAbility(Card& card)
 {
-    card.abilities[2] = 'D';
+    card.abilities |= GC::DRAIN;
 }
 
 bool hasGuardAbility(const Card& card)
 {
-    return card.abilities[3] == 'G';
+    return card.abilities & GC::GUARD;
 }
 
 void addGuardAbility(Card& card)
 {
-    card.abilities[3] = 'G';
+    card.abilities |= GC::GUARD;
 }
 
 bool hasLethalAbility(const Card& card)
 {
-    return card.abilities[4] == 'L';
+    return card.abilities & GC::LETHAL;
 }
 
 void addLethalAbility(Card& card)
 {
-    card.abilities[4] = 'L';
+    card.abilities |= GC::LETHAL;
 }
 
 bool hasWardAbility(const Card& card)
 {
-    return card.abilities[5] == 'W';
+    return card.abilities & GC::WARD;
 }
 
 void addWardAbility(Card& card)
 {
-    card.abilities[5] = 'W';
+    card.abilities |= GC::WARD;
 }
 
 void removeWardAbility(Card& card)
 {
-    card.abilities[5] = '-';
+    card.abilities &= ~GC::WARD;
 }
 
 struct Move
@@ -193,7 +584,7 @@ struct Move
     Move(int type, int target1 = -1, int target2 = -1) :
         type{type}, target1{target1}, target2{target2} {}
 
-    string to_string()
+    string to_string() const
     {
         string res = GC::names[type];
 
@@ -214,15 +605,20 @@ struct Move
 
 using Strategy = vector<Move>;
 
-void output(Strategy& s)
+string toString(const Strategy& s)
 {
-    cout << s[0].to_string();
+    string res = s[0].to_string();
 
-    for (int i = 1; i < s.size(); i++)
+    for (int i = 1; i < (int)s.size(); i++)
     {
-        cout << "; " << s[i].to_string();
+        res += "; " + s[i].to_string();
     }
-    cout << endl;
+    return res;
+}
+
+void output(Strategy& s)
+{
+    cout << toString(s) << endl;
 }
 
 bool isDead(const Card& creature)
@@ -257,6 +653,114 @@ bool isObstacle(const Card& card)
 
 //////////////////////////////////////// 戦略部分 //////////////////////////////////////// 
 
+// 局面のZobristハッシュ。Cardは (cardsのインデックス, 各フィールドの値) ごとに乱数を持つ
+namespace Zobrist
+{
+    using Key = unsigned long long;
+
+    static const int VALUE_RANGE = 64;  // attack / defense はこの範囲に丸める
+    static const int HEALTH_RANGE = 128;
+    static const int MANA_RANGE = 16;
+
+    static Key location[GC::MAX_CARDS][3];
+    static Key canUse[GC::MAX_CARDS][2];
+    static Key attack[GC::MAX_CARDS][VALUE_RANGE];
+    static Key defense[GC::MAX_CARDS][VALUE_RANGE];
+    static Key abilities[GC::MAX_CARDS][1 << GC::ABILITY_COUNT];
+    static Key myHealth[HEALTH_RANGE];
+    static Key myMana[MANA_RANGE];
+    static Key opHealth[HEALTH_RANGE];
+
+    int clamp(int value, int range)
+    {
+        return min(max(value, 0), range - 1);
+    }
+
+    void init()
+    {
+        mt19937_64 mt(20180828);    // 実行ごとに同じ値にしておく
+        for (int i = 0; i < GC::MAX_CARDS; i++)
+        {
+            for (Key& key : location[i]) key = mt();
+            for (Key& key : canUse[i]) key = mt();
+            for (Key& key : attack[i]) key = mt();
+            for (Key& key : defense[i]) key = mt();
+            for (Key& key : abilities[i]) key = mt();
+        }
+        for (Key& key : myHealth) key = mt();
+        for (Key& key : myMana) key = mt();
+        for (Key& key : opHealth) key = mt();
+    }
+
+    // 死んだCreatureはdefenseが0に丸められるので、倒され方が違っても同じ値になる
+    Key card(int index, const Card& card)
+    {
+        return location[index][card.location + 1] ^ canUse[index][card.canUse] ^
+               attack[index][clamp(card.attack, VALUE_RANGE)] ^
+               defense[index][clamp(card.defense, VALUE_RANGE)] ^
+               abilities[index][card.abilities];
+    }
+
+    Key scalars(int health, int mana, int opponentHealth)
+    {
+        return myHealth[clamp(health, HEALTH_RANGE)] ^ myMana[clamp(mana, MANA_RANGE)] ^
+               opHealth[clamp(opponentHealth, HEALTH_RANGE)];
+    }
+};
+
+// 局面の重複を除くための固定サイズの置換表。
+// clear()は世代番号を進めるだけなので、毎回配列を初期化しなくてよい
+struct TranspositionTable
+{
+    static const int SIZE = (1 << 18);
+    static const int PROBE = 4;
+
+    vector<Zobrist::Key> keys;
+    vector<unsigned> stamps;
+    unsigned generation;
+
+    TranspositionTable() : keys(SIZE), stamps(SIZE, 0), generation(1) {}
+
+    void clear()
+    {
+        generation++;
+    }
+
+    // 初めて見る局面ならtrue、登録済みならfalseを返す
+    bool insert(Zobrist::Key key)
+    {
+        int slot = key & (SIZE - 1);
+        for (int i = 0; i < PROBE; i++, slot = (slot + 1) & (SIZE - 1))
+        {
+            if (stamps[slot] != generation)
+            {
+                stamps[slot] = generation;
+                keys[slot] = key;
+                return true;
+            }
+            if (keys[slot] == key) return false;
+        }
+        // 空きがなければ上書きする (重複を見逃すことはあるが、誤って捨てることはない)
+        keys[slot] = key;
+        return true;
+    }
+};
+
+// summon / useGreenItem / attack が書き換える値の記録。
+// 1つの行動で変化するCardは高々2枚なので、その2枚と体力・マナだけを覚えておけば元に戻せる
+// applyが失敗したときは何も記録されず、index1が-1のままになる (unmakeは何もしない)
+struct Undo
+{
+    int myHealth = 0;
+    int myMana = 0;
+    int opHealth = 0;
+    Zobrist::Key hash = 0;
+    int index1 = -1;
+    int index2 = -1;
+    Card card1 = Card();
+    Card card2 = Card();
+};
+
 struct GameNode
 {
     int id;
@@ -270,62 +774,110 @@ struct GameNode
     int opDeck; // 無視
     int opRune; // 無視
     int opHand;   // 無視
-    vector<Card> cards;
+    FixedVector<Card, GC::MAX_CARDS> cards;
+    Zobrist::Key hash;  // summon / useGreenItem / attack で差分更新する
     int score;
     Move move;
 
     GameNode() {}
     GameNode(int myHealth, int myMana, int myDeck, int myRune,
              int opHealth, int opMana, int opDeck, int opRune,
-             int opponentHand, vector<Card>& cards, int score = -INF) :
+             int opponentHand, const FixedVector<Card, GC::MAX_CARDS>& cards, int score = -INF) :
              id{-1}, parent{-1},
              myHealth{myHealth}, myMana{myMana}, myDeck{myDeck}, myRune{myRune},
              opHealth{opHealth}, opMana{opMana}, opDeck{opDeck}, opRune{opRune},
-             opHand{opponentHand}, cards{cards}, score{score} {}
-    GameNode(const GameNode& node) :
-             id{-1}, parent{node.id},
-             myHealth{node.myHealth}, myMana{node.myMana}, myDeck{node.myDeck}, myRune{node.myRune},
-             opHealth{node.opHealth}, opMana{node.opMana}, opDeck{node.opDeck}, opRune{node.opRune},
-             opHand{node.opHand}, cards{node.cards}, score{node.score}, move{node.move} {}
+             opHand{opponentHand}, cards{cards}, score{score}
+    {
+        computeHash();
+    }
 
     static GameNode input()
     {
-        int myHealth, myMana, myDeck, myRune,
-            opHealth, opMana, opDeck, opRune;
-        cin >> myHealth >> myMana >> myDeck >> myRune; cin.ignore();
-        cin >> opHealth >> opMana >> opDeck >> opRune; cin.ignore();
+        int myHealth = reader.readInt(),
+            myMana = reader.readInt(),
+            myDeck = reader.readInt(),
+            myRune = reader.readInt();
+        int opHealth = reader.readInt(),
+            opMana = reader.readInt(),
+            opDeck = reader.readInt(),
+            opRune = reader.readInt();
 
-        int opponentHand;
-        cin >> opponentHand; cin.ignore();
-        
-        int cardCount;
-        cin >> cardCount; cin.ignore();
+        int opponentHand = reader.readInt();
 
-        vector<Card> cards(cardCount);
+        int cardCount = min(reader.readInt(), GC::MAX_CARDS);
+
+        FixedVector<Card, GC::MAX_CARDS> cards;
         for (int i = 0; i < cardCount; i++)
         {
-            cards[i] = Card::input();
+            cards.push_back(Card::input());
         }
         return GameNode(myHealth, myMana, myDeck, myRune,
                         opHealth, opMana, opDeck, opRune, opponentHand, cards);
     }
 
+    // cardsを並べ替えたときなどに、ハッシュを一から計算し直す
+    void computeHash()
+    {
+        hash = Zobrist::scalars(myHealth, myMana, opHealth);
+        for (int i = 0; i < cards.size(); i++) hash ^= Zobrist::card(i, cards[i]);
+    }
+
+    // 変更されるフィールドのハッシュを外し、undoがあれば変更前の値を記録する
+    void beginChange(Undo* undo, int cardIndex1, int cardIndex2)
+    {
+        if (undo != nullptr)
+        {
+            undo->myHealth = myHealth;
+            undo->myMana = myMana;
+            undo->opHealth = opHealth;
+            undo->hash = hash;
+            undo->index1 = cardIndex1;
+            undo->index2 = cardIndex2;
+            undo->card1 = cards[cardIndex1];
+            if (cardIndex2 >= 0) undo->card2 = cards[cardIndex2];
+        }
+        hash ^= Zobrist::scalars(myHealth, myMana, opHealth) ^ Zobrist::card(cardIndex1, cards[cardIndex1]);
+        if (cardIndex2 >= 0) hash ^= Zobrist::card(cardIndex2, cards[cardIndex2]);
+    }
+
+    // 変更後のフィールドのハッシュを戻す
+    void endChange(int cardIndex1, int cardIndex2)
+    {
+        hash ^= Zobrist::scalars(myHealth, myMana, opHealth) ^ Zobrist::card(cardIndex1, cards[cardIndex1]);
+        if (cardIndex2 >= 0) hash ^= Zobrist::card(cardIndex2, cards[cardIndex2]);
+    }
+
+    // summon / useGreenItem / attack で記録した変更を取り消す
+    void unmake(const Undo& undo)
+    {
+        if (undo.index1 < 0) return;
+        myHealth = undo.myHealth;
+        myMana = undo.myMana;
+        opHealth = undo.opHealth;
+        hash = undo.hash;
+        cards[undo.index1] = undo.card1;
+        if (undo.index2 >= 0) cards[undo.index2] = undo.card2;
+    }
+
     // 計算を軽くするため、cardsのインデックスを引数にする
-    bool summon(int cardIndex)
+    // undoを渡すと、変更前の値をそこに記録する
+    bool summon(int cardIndex, Undo* undo = nullptr)
     {
         Card& creature = cards[cardIndex];
+        if (creature.location != GC::MY_HAND or creature.type != GC::CREATURE) return false;
         if (myMana < creature.cost) return false;
 
         int summonedNum = 0;    // 場に出ているCreatureの数
-        for (auto& card : cards) if (card.location == GC::MY_SIDE) summonedNum++;
+        for (auto& card : cards) if (card.location == GC::MY_SIDE and isAlive(card)) summonedNum++;
 
         if (summonedNum >= 6) return false;
 
+        beginChange(undo, cardIndex, -1);
         myMana = max(0, myMana - creature.cost);
         myHealth += creature.myHealthChange;
-        opHealth = max(0, opHealth - creature.opponentHealthChange);
+        // opponentHealthChangeは相手へのダメージが負の値で入っている
+        opHealth = max(0, opHealth + creature.opponentHealthChange);
 
-        // assert(creature.opponentHealthChange <= 0);
         cards[cardIndex].location = GC::MY_SIDE;
 
         if (hasChargeAbility(creature))
@@ -333,6 +885,7 @@ struct GameNode
             cards[cardIndex].canUse = true;
         }
         // 手札については無視
+        endChange(cardIndex, -1);
         return true;
     }
 
@@ -348,41 +901,56 @@ struct GameNode
         return false;
     }
 
-    bool useGreenItem(int cardIndex1, int cardIndex2)
+    bool useGreenItem(int cardIndex1, int cardIndex2, Undo* undo = nullptr)
     {
         Card &item = cards[cardIndex1],
              &cr = cards[cardIndex2];
-        if (myMana < item.cost or isDead(cr)) return false;
+        if (item.type != GC::GREEN_ITEM or !item.canUse) return false;
+        if (myMana < item.cost or cr.location != GC::MY_SIDE or isDead(cr)) return false;
+
+        beginChange(undo, cardIndex1, cardIndex2);
+        myMana -= item.cost;
+        myHealth += item.myHealthChange;
+        opHealth = max(0, opHealth + item.opponentHealthChange);
+        item.canUse = false;    // 使ったアイテムは手札に残さない
 
         cards[cardIndex2].attack += item.attack;
         cards[cardIndex2].defense += item.defense;
-        for (int i = 0; i < 6; i++)
-        {
-            if (item.abilities[i] != '-') cr.abilities[i] = item.abilities[i];
-        }
+        cr.abilities |= item.abilities;
+        endChange(cardIndex1, cardIndex2);
         return true;
     }
 
-    bool attack(int cardIndex1, int cardIndex2)
+    bool attack(int cardIndex1, int cardIndex2, Undo* undo = nullptr)
     {
         if (cardIndex2 < 0) // direct attack
         {
-            if (existsObstacle()) return false;
+            if (!isAttacker(cards[cardIndex1]) or existsObstacle()) return false;
+            beginChange(undo, cardIndex1, -1);
             opHealth -= cards[cardIndex1].attack;
             cards[cardIndex1].canUse = false;
+            endChange(cardIndex1, -1);
             return true;
         }
-        // Wardは無視
         Card &cr1 = cards[cardIndex1],
              &cr2 = cards[cardIndex2];
         if (!isEnemy(cr2) or !isAttacker(cr1)) return false;
+        // Guard持ちが残っている間は、それ以外を攻撃できない
+        if (!hasGuardAbility(cr2) and existsObstacle()) return false;
 
-        cr1.defense -= cr2.attack;
+        beginChange(undo, cardIndex1, cardIndex2);
         cr1.canUse = false;
+        if (cr2.attack > 0)
+        {
+            if (hasWardAbility(cr1)) removeWardAbility(cr1);
+            else if (hasLethalAbility(cr2)) cr1.defense = 0;
+            else cr1.defense -= cr2.attack;
+        }
 
         if (hasWardAbility(cr2))
         {
             removeWardAbility(cr2);
+            endChange(cardIndex1, cardIndex2);
             return true;
         }
 
@@ -398,6 +966,7 @@ struct GameNode
         {
             cr2.defense = 0;
         }
+        endChange(cardIndex1, cardIndex2);
         return true;
     }
 
@@ -406,6 +975,68 @@ struct GameNode
         return cards[idx].id;
     }
 
+    // cardsのインデックスで表された行動を適用する
+    bool apply(const Move& action, Undo* undo = nullptr)
+    {
+        if (action.type == GC::SUMMON) return summon(action.target1, undo);
+        if (action.type == GC::USE) return useGreenItem(action.target1, action.target2, undo);
+        if (action.type == GC::ATTACK) return attack(action.target1, action.target2, undo);
+        return false;
+    }
+
+    // インデックスで表された行動を、出力用のIDで表された行動に直す
+    Move toOutputMove(const Move& action)
+    {
+        if (action.type == GC::SUMMON) return Move(GC::SUMMON, getID(action.target1));
+        int target2 = (action.target2 >= 0) ? getID(action.target2) : -1;
+        return Move(action.type, getID(action.target1), target2);
+    }
+
+    // 現在の局面で合法な行動を列挙する (インデックス表現)
+    template <int N>
+    void legalActions(FixedVector<Move, N>& actions)
+    {
+        actions.clear();
+
+        int summonedNum = 0;
+        for (auto& card : cards) if (card.location == GC::MY_SIDE and isAlive(card)) summonedNum++;
+        bool obstacle = existsObstacle();
+
+        for (int i = 0; i < cards.size(); i++)
+        {
+            Card& card = cards[i];
+            if (card.location == GC::MY_HAND)
+            {
+                if (card.cost > myMana) continue;
+                if (card.type == GC::CREATURE and summonedNum < 6)
+                {
+                    actions.push_back(Move(GC::SUMMON, i));
+                }
+                else if (card.type == GC::GREEN_ITEM and card.canUse)
+                {
+                    for (int j = 0; j < cards.size(); j++)
+                    {
+                        if (cards[j].location == GC::MY_SIDE and isAlive(cards[j]))
+                        {
+                            actions.push_back(Move(GC::USE, i, j));
+                        }
+                    }
+                }
+            }
+            else if (isAttacker(card) and card.attack > 0)
+            {
+                if (!obstacle) actions.push_back(Move(GC::ATTACK, i, -1));
+                for (int j = 0; j < cards.size(); j++)
+                {
+                    if (isEnemy(cards[j]) and (!obstacle or hasGuardAbility(cards[j])))
+                    {
+                        actions.push_back(Move(GC::ATTACK, i, j));
+                    }
+                }
+            }
+        }
+    }
+
     int findReserve(int start = 0)
     {
         int idx = -1;
@@ -482,28 +1113,226 @@ struct GameNode
     }
 };
 
+static_assert(is_trivially_copyable<GameNode>::value, "GameNode must stay trivially copyable");
+
 //                 0, 1, 2, 3, 4, 5, 6, 7+
 int idealDeck[] = {1, 4, 7, 6, 5, 3, 2, 2};
 // int idealDeck[] = {INF, INF, INF, INF, INF, INF, INF, INF};
 int deck[8] = {};
 int creatureNum = 0;
 
-int evaluateCreature(const Card& creature)
+// コンパイル時にカードテーブルから計算できるよう、Cardではなく値を受け取る
+constexpr int evaluateCreature(int cost, int attack, int defense, int abilities, int cardDraw)
 {
-    double score = 1.5 * creature.cost - (creature.attack + creature.defense) / 2;
-    if (hasGuardAbility(creature)) score -= creature.defense;
-    else score -= creature.attack;
+    double score = 1.5 * cost - (attack + defense) / 2;
+    if (abilities & GC::GUARD) score -= defense;
+    else score -= attack;
 
-    if (hasChargeAbility(creature)) score -= 5 + creature.attack;
-    score -= creature.cardDraw * 3;
+    if (abilities & GC::CHARGE) score -= 5 + attack;
+    score -= cardDraw * 3;
 
-    if (hasLethalAbility(creature)) score -= 20;
-    if (hasWardAbility(creature)) score -= 5;
+    if (abilities & GC::LETHAL) score -= 20;
+    if (abilities & GC::WARD) score -= 5;
 
     return score;
 }
 
-Strategy draft(GameNode& node)
+int evaluateCreature(const Card& creature)
+{
+    return evaluateCreature(creature.cost, creature.attack, creature.defense,
+                            creature.abilities, creature.cardDraw);
+}
+
+// 全カードのデータ。cardsはgen_cards.pyがcreature.txtから生成する
+namespace CardDB
+{
+    struct Data
+    {
+        short number;
+        signed char type;
+        signed char cost;
+        short attack;
+        short defense;
+        unsigned char abilities;
+        short myHealthChange;
+        short opponentHealthChange;
+        signed char cardDraw;
+    };
+
+    // ---- BEGIN GENERATED CARD TABLE (gen_cards.py) ----
+    static const int MAX_NUMBER = 116;
+    static constexpr Data cards[] = {
+        { 1, 0, 1, 2, 1, 0, 1, 0, 0 },  // Slimer
+        { 2, 0, 1, 1, 2, 0, 0, -1, 0 },  // Scuttler
+        { 3, 0, 1, 2, 2, 0, 0, 0, 0 },  // Beavrat
+        { 4, 0, 2, 1, 5, 0, 0, 0, 0 },  // Plated Toad
+        { 5, 0, 2, 4, 1, 0, 0, 0, 0 },  // Grime Gnasher
+        { 6, 0, 2, 3, 2, 0, 0, 0, 0 },  // Murgling
+        { 7, 0, 2, 2, 2, 32, 0, 0, 0 },  // Rootkin Sapling
+        { 8, 0, 2, 2, 3, 0, 0, 0, 0 },  // Psyshroom
+        { 9, 0, 3, 3, 4, 0, 0, 0, 0 },  // Corrupted Beavrat
+        { 10, 0, 3, 3, 1, 4, 0, 0, 0 },  // Carnivorous Bush
+        { 11, 0, 3, 5, 2, 0, 0, 0, 0 },  // Snowsaur
+        { 12, 0, 3, 2, 5, 0, 0, 0, 0 },  // Woodshroom
+        { 13, 0, 4, 5, 3, 0, 1, -1, 0 },  // Swamp Terror
+        { 14, 0, 4, 9, 1, 0, 0, 0, 0 },  // Fanged Lunger
+        { 15, 0, 4, 4, 5, 0, 0, 0, 0 },  // Pouncing Flailmouth
+        { 16, 0, 4, 6, 2, 0, 0, 0, 0 },  // Wrangler Fish
+        { 17, 0, 4, 4, 5, 0, 0, 0, 0 },  // Ash Walker
+        { 18, 0, 4, 7, 4, 0, 0, 0, 0 },  // Acid Golem
+        { 19, 0, 5, 5, 6, 0, 0, 0, 0 },  // Foulbeast
+        { 20, 0, 5, 8, 2, 0, 0, 0, 0 },  // Hedge Demon
+        { 21, 0, 5, 6, 5, 0, 0, 0, 0 },  // Crested Scuttler
+        { 22, 0, 6, 7, 5, 0, 0, 0, 0 },  // Sigbovak
+        { 23, 0, 7, 8, 8, 0, 0, 0, 0 },  // Titan Cave Hog
+        { 24, 0, 1, 1, 1, 0, 0, -1, 0 },  // Exploding Skitterbug
+        { 25, 0, 2, 3, 1, 0, -2, -2, 0 },  // Spiney Chompleaf
+        { 26, 0, 2, 3, 2, 0, 0, -1, 0 },  // Razor Crab
+        { 27, 0, 2, 2, 2, 0, 2, 0, 0 },  // Nut Gatherer
+        { 28, 0, 2, 1, 2, 0, 0, 0, 1 },  // Infested Toad
+        { 29, 0, 2, 2, 1, 0, 0, 0, 1 },  // Steelplume Nestling
+        { 30, 0, 3, 4, 2, 0, 0, -2, 0 },  // Venomous Bog Hopper
+        { 31, 0, 3, 3, 1, 0, 0, -1, 0 },  // Woodland Hunter
+        { 32, 0, 3, 3, 2, 0, 0, 0, 1 },  // Sandsplat
+        { 33, 0, 4, 4, 3, 0, 0, 0, 1 },  // Chameleskulk
+        { 34, 0, 5, 3, 5, 0, 0, 0, 1 },  // Eldritch Cyclops
+        { 35, 0, 6, 5, 2, 1, 0, 0, 1 },  // Snail-eyed Hulker
+        { 36, 0, 6, 4, 4, 0, 0, 0, 2 },  // Possessed Skull
+        { 37, 0, 6, 5, 7, 0, 0, 0, 1 },  // Eldritch Multiclops
+        { 38, 0, 1, 1, 3, 4, 0, 0, 0 },  // Imp
+        { 39, 0, 1, 2, 1, 4, 0, 0, 0 },  // Voracious Imp
+        { 40, 0, 3, 2, 3, 12, 0, 0, 0 },  // Rock Gobbler
+        { 41, 0, 3, 2, 2, 6, 0, 0, 0 },  // Blizzard Demon
+        { 42, 0, 4, 4, 2, 4, 0, 0, 0 },  // Flying Leech
+        { 43, 0, 6, 5, 5, 4, 0, 0, 0 },  // Screeching Nightmare
+        { 44, 0, 6, 3, 7, 20, 0, 0, 0 },  // Deathstalker
+        { 45, 0, 6, 6, 5, 5, -3, 0, 0 },  // Night Howler
+        { 46, 0, 9, 7, 7, 4, 0, 0, 0 },  // Soul Devourer
+        { 47, 0, 2, 1, 5, 4, 0, 0, 0 },  // Gnipper
+        { 48, 0, 1, 1, 1, 16, 0, 0, 0 },  // Venom Hedgehog
+        { 49, 0, 2, 1, 2, 24, 0, 0, 0 },  // Shiny Prowler
+        { 50, 0, 3, 3, 2, 16, 0, 0, 0 },  // Puff Biter
+        { 51, 0, 4, 3, 5, 16, 0, 0, 0 },  // Elite Bilespitter
+        { 52, 0, 4, 2, 4, 16, 0, 0, 0 },  // Bilespitter
+        { 53, 0, 4, 1, 1, 18, 0, 0, 0 },  // Possessed Abomination
+        { 54, 0, 3, 2, 2, 16, 0, 0, 0 },  // Shadow Biter
+        { 55, 0, 2, 0, 5, 8, 0, 0, 0 },  // Hermit Slime
+        { 56, 0, 4, 2, 7, 0, 0, 0, 0 },  // Giant Louse
+        { 57, 0, 4, 1, 8, 0, 0, 0, 0 },  // Dream-Eater
+        { 58, 0, 6, 5, 6, 1, 0, 0, 0 },  // Darkscale Predator
+        { 59, 0, 7, 7, 7, 0, 1, -1, 0 },  // Sea Ghost
+        { 60, 0, 7, 4, 8, 0, 0, 0, 0 },  // Gritsuck Troll
+        { 61, 0, 9, 10, 10, 0, 0, 0, 0 },  // Alpha Troll
+        { 62, 0, 12, 12, 12, 9, 0, 0, 0 },  // Mutant Troll
+        { 63, 0, 2, 0, 4, 40, 0, 0, 0 },  // Rootkin Drone
+        { 64, 0, 2, 1, 1, 40, 0, 0, 0 },  // Coppershell Tortoise
+        { 65, 0, 2, 2, 2, 32, 0, 0, 0 },  // Steelplume Defender
+        { 66, 0, 5, 5, 1, 32, 0, 0, 0 },  // Staring Wickerbeast
+        { 67, 0, 6, 5, 5, 32, 0, -2, 0 },  // Flailing Hammerhead
+        { 68, 0, 6, 7, 5, 32, 0, 0, 0 },  // Giant Squid
+        { 69, 0, 3, 4, 4, 1, 0, 0, 0 },  // Charging Boarhound
+        { 70, 0, 4, 6, 3, 1, 0, 0, 0 },  // Murglord
+        { 71, 0, 4, 3, 2, 3, 0, 0, 0 },  // Flying Murgling
+        { 72, 0, 4, 5, 3, 1, 0, 0, 0 },  // Shuffling Nightmare
+        { 73, 0, 4, 4, 4, 1, 4, 0, 0 },  // Bog Bounder
+        { 74, 0, 5, 5, 4, 9, 0, 0, 0 },  // Crusher
+        { 75, 0, 5, 6, 5, 1, 0, 0, 0 },  // Titan Prowler
+        { 76, 0, 6, 5, 5, 5, 0, 0, 0 },  // Crested Chomper
+        { 77, 0, 7, 7, 7, 1, 0, 0, 0 },  // Lumbering Giant
+        { 78, 0, 8, 5, 5, 1, 0, -5, 0 },  // Shambler
+        { 79, 0, 8, 8, 8, 1, 0, 0, 0 },  // Scarlet Colossus
+        { 80, 0, 8, 8, 8, 9, 0, 0, 1 },  // Corpse Guzzler
+        { 81, 0, 9, 6, 6, 3, 0, 0, 0 },  // Flying Corpse Guzzler
+        { 82, 0, 7, 5, 5, 37, 0, 0, 0 },  // Slithering Nightmare
+        { 83, 0, 0, 1, 1, 2, 0, 0, 0 },  // Restless Owl
+        { 84, 0, 2, 1, 1, 38, 0, 0, 0 },  // Fighter Tick
+        { 85, 0, 3, 2, 3, 2, 0, 0, 0 },  // Heartless Crow
+        { 86, 0, 3, 1, 5, 2, 0, 0, 0 },  // Crazed Nose-pincher
+        { 87, 0, 4, 2, 5, 10, 0, 0, 0 },  // Bloat Demon
+        { 88, 0, 5, 4, 4, 2, 0, 0, 0 },  // Abyss Nightmare
+        { 89, 0, 5, 4, 1, 2, 2, 0, 0 },  // Boombeak
+        { 90, 0, 8, 5, 5, 2, 0, 0, 0 },  // Eldritch Swooper
+        { 91, 0, 0, 1, 2, 8, 0, 1, 0 },  // Flumpy
+        { 92, 0, 1, 0, 1, 8, 2, 0, 0 },  // Wurm
+        { 93, 0, 1, 2, 1, 8, 0, 0, 0 },  // Spinekid
+        { 94, 0, 2, 1, 4, 8, 0, 0, 0 },  // Rootkin Defender
+        { 95, 0, 2, 2, 3, 8, 0, 0, 0 },  // Wildum
+        { 96, 0, 2, 3, 2, 8, 0, 0, 0 },  // Prairie Protector
+        { 97, 0, 3, 3, 3, 8, 0, 0, 0 },  // Turta
+        { 98, 0, 3, 2, 4, 8, 0, 0, 0 },  // Lilly Hopper
+        { 99, 0, 3, 2, 5, 8, 0, 0, 0 },  // Cave Crab
+        { 100, 0, 3, 1, 6, 8, 0, 0, 0 },  // Stalagopod
+        { 101, 0, 4, 3, 4, 8, 0, 0, 0 },  // Engulfer
+        { 102, 0, 4, 3, 3, 8, 0, -1, 0 },  // Mole Demon
+        { 103, 0, 4, 3, 6, 8, 0, 0, 0 },  // Mutating Rootkin
+        { 104, 0, 4, 4, 4, 8, 0, 0, 0 },  // Deepwater Shellcrab
+        { 105, 0, 5, 4, 6, 8, 0, 0, 0 },  // King Shellcrab
+        { 106, 0, 5, 5, 5, 8, 0, 0, 0 },  // Far-reaching Nightmare
+        { 107, 0, 5, 3, 3, 8, 3, 0, 0 },  // Worker Shellcrab
+        { 108, 0, 5, 2, 6, 8, 0, 0, 0 },  // Rootkin Elder
+        { 109, 0, 5, 5, 6, 0, 0, 0, 0 },  // Elder Engulfer
+        { 110, 0, 5, 0, 9, 8, 0, 0, 0 },  // Gargoyle
+        { 111, 0, 6, 6, 6, 8, 0, 0, 0 },  // Turta Knight
+        { 112, 0, 6, 4, 7, 8, 0, 0, 0 },  // Rootkin Leader
+        { 113, 0, 6, 2, 4, 8, 4, 0, 0 },  // Tamed Bilespitter
+        { 114, 0, 7, 7, 7, 8, 0, 0, 0 },  // Gargantua
+        { 115, 0, 8, 5, 5, 40, 0, 0, 0 },  // Rootkin Warchief
+        { 116, 0, 12, 8, 8, 63, 0, 0, 0 },  // Emperor Nightmare
+    };
+    // ---- END GENERATED CARD TABLE ----
+
+    // ドラフトで必ず取るカード
+    static const int CORPSE_GUZZLER = 80;
+    static const int FLYING_CORPSE_GUZZLER = 81;
+
+    // numberから引く、あらかじめ計算しておいた値
+    struct Entry
+    {
+        bool known;
+        int costBucket;     // idealDeckの添字 (コスト7以上は7にまとめる)
+        int baseScore;      // evaluateCreatureの値
+    };
+
+    struct Table
+    {
+        Entry entries[MAX_NUMBER + 1];
+    };
+
+    constexpr Table buildTable()
+    {
+        Table table = {};
+        for (const Data& card : cards)
+        {
+            Entry& entry = table.entries[card.number];
+            entry.known = true;
+            entry.costBucket = card.cost < 7 ? card.cost : 7;
+            entry.baseScore = evaluateCreature(card.cost, card.attack, card.defense,
+                                               card.abilities, card.cardDraw);
+        }
+        return table;
+    }
+
+    static constexpr Table table = buildTable();
+
+    bool contains(int number)
+    {
+        return 0 <= number and number <= MAX_NUMBER and table.entries[number].known;
+    }
+
+    // テーブルにないカードは、その場の値から計算する
+    int costBucket(const Card& card)
+    {
+        return contains(card.number) ? table.entries[card.number].costBucket : min<int>(card.cost, 7);
+    }
+
+    int baseScore(const Card& card)
+    {
+        return contains(card.number) ? table.entries[card.number].baseScore : evaluateCreature(card);
+    }
+};
+
+// コストごとの枚数の目安 (idealDeck) を守りつつ、評価値の良いCreatureを取る
+int pickByHeuristic(GameNode& node)
 {
     int reserve = 0,
         target = -1;
@@ -512,11 +1341,11 @@ Strategy draft(GameNode& node)
     for (int i = 0; i < 3; i++)
     {
         Card& card = node.cards[i];
-        int cost = min(card.cost, 7);
+        int cost = CardDB::costBucket(card);
 
-        if (card.number == 80 or card.number == 81)
+        if (card.number == CardDB::CORPSE_GUZZLER or card.number == CardDB::FLYING_CORPSE_GUZZLER)
         {
-            return Strategy({ Move(GC::PICK, i) });
+            return i;
         }
 
         if (card.type == GC::GREEN_ITEM)
@@ -535,180 +1364,310 @@ Strategy draft(GameNode& node)
         {
             reserve = i;
         }
-        else if (target < 0 or evaluateCreature(targetCreature) > evaluateCreature(card))
+        else if (target < 0 or CardDB::baseScore(targetCreature) > CardDB::baseScore(card))
         {
             targetCreature = card;
             target = i;
         }
     }
     if (target < 0) target = reserve;
-    if (node.cards[target].type == GC::CREATURE) creatureNum++;
-    deck[min(7, node.cards[target].cost)]++;
-
-    return Strategy{ Move(GC::PICK, target) };
+    return target;
 }
 
-Strategy targetObstacles(GameNode& node)
+// ドラフト用の軽量な対戦シミュレータ。
+// 両者とも「重いCreatureから召喚し、残りのマナでItemを使い、Guard持ちを倒してから顔を殴る」方針で最後まで対戦させる。
+namespace Playout
 {
-    Strategy strategy;
+    const int DECK_SIZE = 30;
+    const int MAX_TURNS = 50;
+    const int MAX_HAND = 8;
+    const int MAX_BOARD = 6;
 
-    // Guard持ちを攻撃
-    int obstacleI = 0;
-    while ((obstacleI = node.findObstacle()) != -1)
+    struct Unit
     {
-        Card& obstacle = node.cards[obstacleI];
+        short attack;
+        short defense;
+        unsigned char abilities;
+        bool canAttack;
+    };
 
-        int idx = 0;
-        vector<int> attackerIndexes;
-        while ((idx = node.findAttacker(idx)) != -1)
-        {
-            attackerIndexes.push_back(idx);
-            idx++;
-        }
-
-        int bestAttackerI = -1, bestScore = (1 << 28);
-        for (int attackerI : attackerIndexes)
+    struct Side
+    {
+        int health;
+        int nextRune;
+        int deckSize;
+        int handSize;
+        int boardSize;
+        const CardDB::Data* deck[DECK_SIZE];
+        const CardDB::Data* hand[MAX_HAND];
+        Unit board[MAX_BOARD];
+    };
+
+    void draw(Side& side)
+    {
+        if (side.deckSize == 0)
         {
-            Card& attacker = node.cards[attackerI];
-            if (attacker.attack == 0)
-            {
-                attacker.canUse = false;
-                continue;
-            }
-            int score = -(20 * (hasLethalAbility(attacker) or attacker.attack >= obstacle.defense)
-                            - (attacker.attack + attacker.defense));
-            
-            if (score < bestScore)
-            {
-                bestScore = score;
-                bestAttackerI = attackerI;
-            }
+            side.health = min(side.health, side.nextRune);
+            side.nextRune -= 5;
+            return;
         }
+        const CardDB::Data* card = side.deck[--side.deckSize];
+        if (side.handSize < MAX_HAND) side.hand[side.handSize++] = card;
+    }
 
-        if (bestAttackerI < 0) break;
+    void removeUnit(Side& side, int i)
+    {
+        side.board[i] = side.board[--side.boardSize];
+    }
 
-        if (node.attack(bestAttackerI, obstacleI))
+    // ダメージを与え、実際に与えた量を返す
+    int dealDamage(Unit& unit, int damage, bool lethal)
+    {
+        if (damage <= 0) return 0;
+        if (unit.abilities & GC::WARD)
         {
-            strategy.emplace_back(GC::ATTACK, node.getID(bestAttackerI), node.getID(obstacleI));
+            unit.abilities &= ~GC::WARD;
+            return 0;
         }
+        int dealt = min<int>(damage, unit.defense);
+        unit.defense = lethal ? 0 : unit.defense - damage;
+        return dealt;
     }
-    return strategy;
-}
-
-int findBestAttacker(GameNode& node, int target)
-{
-    if (target < 0) return node.findAttacker();
 
-    Card& targetCreature = node.cards[target];
+    // 手札から出したカードに共通の効果 (体力の増減とドロー)
+    void playCard(Side& me, Side& op, int i)
+    {
+        const CardDB::Data* card = me.hand[i];
+        me.hand[i] = me.hand[--me.handSize];
+        me.health += card->myHealthChange;
+        op.health += card->opponentHealthChange;
+        for (int n = 0; n < card->cardDraw; n++) draw(me);
+    }
 
-    int bestAttackerI = -1,
-        bestScore = -INF;
-    for (int i = 0; i < node.cards.size(); i++)
+    // Itemを使う。対象がいなければfalseを返す
+    //   Green: 攻撃力の最も高い味方に付与
+    //   Red:   Guard持ち (いなければ攻撃力の最も高い敵) から能力を奪い、ダメージを与える
+    //   Blue:  相手の顔にダメージ
+    bool useItem(Side& me, Side& op, const CardDB::Data* card)
     {
-        Card& card = node.cards[i];
-        if (!isAttacker(card)) continue;
+        if (card->type == GC::BLUE_ITEM)
+        {
+            op.health += card->defense;
+            return true;
+        }
 
-        int score = -(card.attack + card.defense) / 2;
-        if (hasWardAbility(targetCreature)) score = - card.attack * card.attack * 5;
-        else if (hasLethalAbility(card) or card.attack >= targetCreature.attack) score += 10;
+        Side& side = card->type == GC::GREEN_ITEM ? me : op;
+        int target = -1;
+        for (int j = 0; j < side.boardSize; j++)
+        {
+            if (target < 0 or side.board[j].attack > side.board[target].attack) target = j;
+        }
+        if (card->type == GC::RED_ITEM)
+        {
+            for (int j = 0; j < side.boardSize; j++) if (side.board[j].abilities & GC::GUARD) target = j;
+        }
+        if (target < 0) return false;
 
-        if (score > bestScore)
+        Unit& unit = side.board[target];
+        if (card->type == GC::GREEN_ITEM)
         {
-            bestAttackerI = i;
-            bestScore = score;
+            unit.attack += card->attack;
+            unit.defense += card->defense;
+            unit.abilities |= card->abilities;
+            if (card->abilities & GC::CHARGE) unit.canAttack = true;
         }
+        else
+        {
+            unit.abilities &= ~card->abilities;
+            unit.attack = max(0, unit.attack + card->attack);
+            dealDamage(unit, -card->defense, false);
+            if (unit.defense <= 0) removeUnit(op, target);
+        }
+        return true;
     }
-    return bestAttackerI;
-}
 
-// 攻撃力が高いのに体力が少ないやつ
-int findTarget(GameNode& node)
-{
-    int target = -1,
-        bestScore = -INF;
-    for (int i = 0; i < node.cards.size(); i++)
+    void playTurn(Side& me, Side& op, int mana)
     {
-        Card& card = node.cards[i];
-        int score = (card.attack - card.defense) + hasDrainAbility(card) * 3;
+        for (int i = 0; i < me.boardSize; i++) me.board[i].canAttack = true;
 
-        if (isEnemy(card) and bestScore < score)
+        // 重いCreatureから召喚する
+        while (me.boardSize < MAX_BOARD)
         {
-            target = i;
-            bestScore = score;
+            int best = -1;
+            for (int i = 0; i < me.handSize; i++)
+            {
+                const CardDB::Data* card = me.hand[i];
+                if (card->type != GC::CREATURE or card->cost > mana) continue;
+                if (best < 0 or card->cost > me.hand[best]->cost) best = i;
+            }
+            if (best < 0) break;
+
+            const CardDB::Data* card = me.hand[best];
+            playCard(me, op, best);
+            mana -= card->cost;
+            me.board[me.boardSize++] = Unit{ card->attack, card->defense, card->abilities,
+                                             (card->abilities & GC::CHARGE) != 0 };
         }
-    }
-    return target;
-}
 
-Strategy attack(GameNode& node)
-{
-    Strategy strategy = targetObstacles(node);
+        // 残ったマナでItemを使う
+        for (int i = 0; i < me.handSize; )
+        {
+            const CardDB::Data* card = me.hand[i];
+            if (card->type == GC::CREATURE or card->cost > mana or !useItem(me, op, card))
+            {
+                i++;
+                continue;
+            }
+            playCard(me, op, i);
+            mana -= card->cost;
+        }
 
-    // 自分の攻撃力、相手の攻撃力、自分の守備力を計算
-    int myAttack = 0,
-        myDefense = 0,
-        opAttack = 0;
-    for (Card& card : node.cards)
-    {
-        if (isEnemy(card))
+        for (int i = 0; i < me.boardSize and op.health > 0; i++)
         {
-            opAttack += card.attack;
-            continue;
+            Unit& attacker = me.board[i];
+            if (!attacker.canAttack or attacker.attack <= 0) continue;
+            attacker.canAttack = false;
+
+            int guard = -1;
+            for (int j = 0; j < op.boardSize; j++) if (op.board[j].abilities & GC::GUARD) guard = j;
+
+            int dealt;
+            if (guard < 0)
+            {
+                dealt = attacker.attack;
+                op.health -= dealt;
+            }
+            else
+            {
+                Unit& defender = op.board[guard];
+                dealt = dealDamage(defender, attacker.attack, attacker.abilities & GC::LETHAL);
+                dealDamage(attacker, defender.attack, defender.abilities & GC::LETHAL);
+                if (defender.defense <= 0) removeUnit(op, guard);
+            }
+            if (attacker.abilities & GC::DRAIN) me.health += dealt;
+            if (attacker.defense <= 0)
+            {
+                removeUnit(me, i);
+                i--;    // 詰めた後の同じ位置をもう一度見る
+            }
         }
-        else if (card.location != GC::MY_SIDE) continue;
+    }
 
-        if (isAttacker(card)) myAttack += card.attack;
-        if (isAlive(card) and hasGuardAbility(card)) myDefense += card.defense;
+    void setup(Side& side, const CardDB::Data* const* deck, int handSize)
+    {
+        side.health = 30;
+        side.nextRune = 25;
+        side.deckSize = DECK_SIZE;
+        side.handSize = side.boardSize = 0;
+        for (int i = 0; i < DECK_SIZE; i++) side.deck[i] = deck[i];
+        for (int i = DECK_SIZE - 1; i > 0; i--) swap(side.deck[i], side.deck[Random::randInt(i + 1)]);
+        for (int i = 0; i < handSize; i++) draw(side);
     }
 
-    // 後で直す
-    while (true)
+    // deck0が勝てば1、負ければ0、決着がつかなければ0.5を返す
+    double play(const CardDB::Data* const* deck0, const CardDB::Data* const* deck1, bool deck0First)
     {
-        int obstacleI = node.findObstacle(),
-            bestAttackerI = -1,
-            target = -1;
+        Side sides[2];
+        int first = deck0First ? 0 : 1;
+        setup(sides[first], first == 0 ? deck0 : deck1, 4);
+        setup(sides[1 - first], first == 0 ? deck1 : deck0, 5);
 
-        if (obstacleI >= 0)
-        {
-            bestAttackerI = findBestAttacker(node, obstacleI);
-            target = obstacleI;
-        }
-        else if (node.opHealth < 10 or opAttack - myDefense < 5)
+        for (int turn = 0; turn < 2 * MAX_TURNS; turn++)
         {
-            // 敵をダイレクトアタック
-            bestAttackerI = findBestAttacker(node, -1);
-            target = -1;
-        }
-        else
-        {
-            target = findTarget(node);
-            bestAttackerI = findBestAttacker(node, target);
+            Side &me = sides[(first + turn) % 2],
+                 &op = sides[(first + turn + 1) % 2];
+            draw(me);
+            playTurn(me, op, min(12, turn / 2 + 1));
+
+            if (sides[1].health <= 0) return 1.0;
+            if (sides[0].health <= 0) return 0.0;
         }
-        if (bestAttackerI < 0) break;
+        return 0.5;
+    }
+};
+
+const bool SIMULATION_DRAFT = true;     // falseならpickByHeuristicを使う
+
+// これまでに取ったカード
+FixedVector<CardDB::Data, Playout::DECK_SIZE> myPicks;
 
-        Card& attacker = node.cards[bestAttackerI];
+CardDB::Data toCardData(const Card& card)
+{
+    return CardDB::Data{ card.number, card.type, card.cost, card.attack, card.defense, card.abilities,
+                         card.myHealthChange, card.opponentHealthChange, card.cardDraw };
+}
+
+// 3枚の候補それぞれについて「今のデッキ + 候補 + 残りをランダムに補ったデッキ」で
+// ランダムな相手デッキと対戦させ、勝率が最も高い候補を取る
+int pickBySimulation(GameNode& node)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        int number = node.cards[i].number;
+        if (number == CardDB::CORPSE_GUZZLER or number == CardDB::FLYING_CORPSE_GUZZLER) return i;
+    }
+
+    const int poolSize = sizeof(CardDB::cards) / sizeof(CardDB::cards[0]);
+
+    CardDB::Data candidates[3];
+    for (int i = 0; i < 3; i++) candidates[i] = toCardData(node.cards[i]);
+
+    double wins[3] = {};
+    int playouts[3] = {};
 
-        int curDefense = attacker.defense;
-        myAttack -= attacker.attack;
+    const CardDB::Data* myDeck[Playout::DECK_SIZE];
+    const CardDB::Data* opDeck[Playout::DECK_SIZE];
 
-        if (node.attack(bestAttackerI, target))
+    for (int n = 0; !timeManager.isOver(); n++)
+    {
+        // 相手デッキとランダムに補う分は、3つの候補で同じものを使って比較のばらつきを抑える
+        for (int i = 0; i < Playout::DECK_SIZE; i++)
         {
-            int targetID = (target >= 0) ? node.getID(target) : (-1);
-            strategy.emplace_back(Move(GC::ATTACK, node.getID(bestAttackerI), targetID));
+            opDeck[i] = &CardDB::cards[Random::randInt(poolSize)];
         }
-        else cerr << "ERROR" << endl;
-
-        if (isDead(attacker))
+        for (int i = 0; i < myPicks.size(); i++) myDeck[i] = &myPicks[i];
+        for (int i = myPicks.size() + 1; i < Playout::DECK_SIZE; i++)
         {
-            myDefense -= curDefense;
+            myDeck[i] = &CardDB::cards[Random::randInt(poolSize)];
         }
-        if (target >= 0 and isDead(node.cards[target]))
+
+        for (int c = 0; c < 3; c++)
         {
-            opAttack -= node.cards[target].attack;
+            myDeck[myPicks.size()] = &candidates[c];
+            wins[c] += Playout::play(myDeck, opDeck, n % 2 == 0);
+            playouts[c]++;
         }
     }
 
-    return strategy;
+    // 1回も対戦できなかったときは比較のしようがないのでヒューリスティックに任せる
+    if (playouts[0] == 0) return pickByHeuristic(node);
+
+    int best = 0;
+    for (int c = 1; c < 3; c++)
+    {
+        if (wins[c] > wins[best]) best = c;
+    }
+    Stats::count(Stats::PLAYOUTS, playouts[0] * 3);
+    return best;
+}
+
+Strategy draft(GameNode& node)
+{
+    Stats::Scope scope(Stats::DRAFT);
+    int target = SIMULATION_DRAFT ? pickBySimulation(node) : pickByHeuristic(node);
+    return Strategy{ Move(GC::PICK, target) };
+}
+
+// 出力したPICKのカードをデッキに加える。リプレイでは記録された出力を渡すので、
+// 再計算した手が違っていても以降のターンは本番と同じデッキで考える
+void applyOutput(const GameNode& node, const string& output)
+{
+    int target;
+    if (sscanf(output.c_str(), "PICK %d", &target) != 1) return;
+
+    if (node.cards[target].type == GC::CREATURE) creatureNum++;
+    deck[CardDB::costBucket(node.cards[target])]++;
+    myPicks.push_back(toCardData(node.cards[target]));
 }
 
 Strategy useGreenItem(GameNode& node)
@@ -718,9 +1677,6 @@ Strategy useGreenItem(GameNode& node)
 
     while ((idx = node.findGreenItem(idx)) != -1)
     {
-        cerr << "greenItem!!!" << endl;
-
-        Card& item = node.cards[idx];
         int attacker = node.findAttacker();
 
         if (attacker < 0) break;
@@ -742,7 +1698,6 @@ Strategy summon(GameNode& node)
 
     while ((idx = node.findReserve(idx)) != -1)
     {
-        Card& reserve = node.cards[idx];
         if (node.summon(idx))
         {
             strategy.emplace_back(Move(GC::SUMMON, node.getID(idx)));
@@ -754,6 +1709,407 @@ Strategy summon(GameNode& node)
     return strategy;
 }
 
+//////////////////////////////////////// 探索部分 //////////////////////////////////////// 
+
+// 持ち時間のうち、リーサル探索と貪欲な行動列の計算に使ってよい割合 (残りはビームサーチに使う)
+const double GREEDY_TIME_RATIO = 0.1;
+const int MAX_ACTIONS = 128;
+const int MAX_SEARCH_DEPTH = 24;
+const int INITIAL_BEAM_WIDTH = 4;
+
+// 場に出ているCreatureの価値
+int evaluateBoardCreature(const Card& creature)
+{
+    if (isDead(creature)) return 0;
+
+    int score = 2 * creature.attack + 2 * creature.defense;
+    if (hasGuardAbility(creature)) score += creature.defense;
+    if (hasLethalAbility(creature)) score += 5;
+    if (hasWardAbility(creature)) score += creature.attack + 2;
+    if (hasDrainAbility(creature)) score += creature.attack;
+    if (hasBreakthroughAbility(creature)) score += 1;
+    return score;
+}
+
+// 体力は少なくなるほど1点の重みが増す
+int evaluateHealth(int health)
+{
+    return 2 * health + 3 * max(0, 10 - health);
+}
+
+// ターン終了時の局面の評価値 (大きいほど自分に有利)
+int evaluateNode(const GameNode& node)
+{
+    Stats::count(Stats::EVALUATIONS);
+    if (node.opHealth <= 0) return INF;
+
+    int score = evaluateHealth(node.myHealth) - evaluateHealth(node.opHealth);
+    for (const Card& card : node.cards)
+    {
+        if (card.location == GC::MY_SIDE) score += evaluateBoardCreature(card);
+        else if (card.location == GC::OP_SIDE) score -= evaluateBoardCreature(card);
+    }
+    return score;
+}
+
+// このターンで相手の体力を0にできるかを厳密に判定する。
+// Guard持ちを倒す攻撃、Chargeや召喚時ダメージを持つCreatureの召喚、攻撃できるCreatureへのアイテム使用だけを
+// make/unmakeで深さ優先に試す。手順が違うだけの同じ局面は置換表で1度しか調べない。
+// 探索を途中で打ち切らないので、falseは「上の行動だけではリーサルがない」ことを意味する
+// (1ターンの行動は手札8枚と場の6体で14回までなので、MAX_SEARCH_DEPTHに届くことはない)。
+// 盤面が重いときでも数百us以内に終わる。
+struct LethalSolver
+{
+    GameNode node;
+    TranspositionTable visited;
+    FixedVector<Move, MAX_ACTIONS> actions[MAX_SEARCH_DEPTH];
+    Strategy path;
+
+    // リーサルに関係する行動か。アイテムは既に攻撃できるCreatureに使うものだけを試し、
+    // このターンに召喚したばかりのCreatureへの使用 (Chargeを付けるGreen Itemなど) はあえて対象にしない
+    bool isLethalAction(const Move& action, bool obstacle)
+    {
+        const Card& card = node.cards[action.target1];
+        if (action.type == GC::SUMMON)
+        {
+            return hasChargeAbility(card) or card.opponentHealthChange < 0;
+        }
+        if (action.type == GC::USE)
+        {
+            return isAttacker(node.cards[action.target2]);
+        }
+        // Guard持ちがいなければ、残りの攻撃はすべて顔に向ければよいので分岐しない
+        return obstacle and action.target2 >= 0;
+    }
+
+    // 残りの手札を全部使えたときに与えられるダメージの上界
+    int damageUpperBound()
+    {
+        int damage = 0;
+        for (const Card& card : node.cards)
+        {
+            if (isAttacker(card)) damage += card.attack;
+            else if (card.location != GC::MY_HAND or card.cost > node.myMana) continue;
+            else if (card.type == GC::CREATURE)
+            {
+                damage -= card.opponentHealthChange;
+                if (hasChargeAbility(card)) damage += card.attack;
+            }
+            else if (card.type == GC::GREEN_ITEM and card.canUse)
+            {
+                damage += max(0, (int)card.attack) - card.opponentHealthChange;
+            }
+        }
+        return damage;
+    }
+
+    bool dfs(int depth)
+    {
+        if (node.opHealth <= 0) return true;
+        if (depth >= MAX_SEARCH_DEPTH) return false;
+        Stats::count(Stats::NODES);
+        if (!visited.insert(node.hash)) return false;
+        if (damageUpperBound() < node.opHealth) return false;
+
+        bool obstacle = node.existsObstacle();
+        if (!obstacle)
+        {
+            int damage = 0;
+            for (const Card& card : node.cards) if (isAttacker(card)) damage += card.attack;
+            if (damage >= node.opHealth)
+            {
+                for (int i = 0; i < node.cards.size(); i++)
+                {
+                    if (isAttacker(node.cards[i]) and node.cards[i].attack > 0)
+                    {
+                        path.push_back(Move(GC::ATTACK, node.getID(i), -1));
+                    }
+                }
+                return true;
+            }
+        }
+
+        auto& candidates = actions[depth];
+        node.legalActions(candidates);
+        for (const Move& action : candidates)
+        {
+            if (!isLethalAction(action, obstacle)) continue;
+
+            Move output = node.toOutputMove(action);
+            Undo undo;
+            if (!node.apply(action, &undo)) continue;
+
+            path.push_back(output);
+            if (dfs(depth + 1)) return true;
+            path.pop_back();
+            node.unmake(undo);
+        }
+        return false;
+    }
+
+    // リーサルがあればtrueを返し、strategyにその手順を入れる
+    bool solve(const GameNode& root, Strategy& strategy)
+    {
+        node = root;
+        visited.clear();
+        path.clear();
+
+        if (!dfs(0)) return false;
+        strategy = path;
+        return true;
+    }
+};
+
+// リーサルがないときの攻撃の割り当てを分枝限定法で決める。
+// Guard持ちが残っている間は (攻撃するCreature, Guard持ち) の組を順不同に試し、
+// Guard持ちがいなくなった後は攻撃の順番が結果に影響しないので、残りのCreatureを順番に
+// 「敵Creature / 顔 / 攻撃しない」のどれかに割り当てる。目的関数はevaluateNodeの値。
+struct AttackPlanner
+{
+    static const int TIME_LIMIT = 2000;  // [us]
+
+    GameNode node;
+    TranspositionTable visited;
+    FixedVector<Move, MAX_ACTIONS> actions[MAX_SEARCH_DEPTH];
+    FixedVector<Move, MAX_SEARCH_DEPTH> path, bestPath;
+    int bestScore;
+
+    // 1体のCreatureの攻撃で評価値が増える量の上界
+    // (体力1点の価値は高々5、敵Creatureを倒して増えるのは高々そのCreatureの価値)
+    int optimisticGain(const Card& attacker)
+    {
+        int gain = 5 * attacker.attack;
+        for (const Card& card : node.cards)
+        {
+            if (isEnemy(card)) gain = max(gain, evaluateBoardCreature(card));
+        }
+        if (hasDrainAbility(attacker)) gain += 5 * attacker.attack;
+        return gain;
+    }
+
+    void update()
+    {
+        int score = evaluateNode(node);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestPath = path;
+        }
+    }
+
+    bool tryAction(const Move& action, int depth, int start)
+    {
+        Undo undo;
+        if (!node.apply(action, &undo)) return false;
+        path.push_back(action);
+        dfs(depth + 1, start);
+        path.pop_back();
+        node.unmake(undo);
+        return true;
+    }
+
+    // startはGuard持ちがいなくなった後に割り当てを決めるCreatureの位置
+    void dfs(int depth, int start)
+    {
+        if (timeManager.isOver() or depth >= MAX_SEARCH_DEPTH) return;
+        Stats::count(Stats::NODES);
+        update();
+
+        int bound = evaluateNode(node);
+        if (bound >= INF) return;
+        for (int i = start; i < node.cards.size(); i++)
+        {
+            if (isAttacker(node.cards[i])) bound += optimisticGain(node.cards[i]);
+        }
+        if (bound <= bestScore) return;
+
+        if (node.existsObstacle())
+        {
+            if (!visited.insert(node.hash)) return;
+
+            auto& candidates = actions[depth];
+            node.legalActions(candidates);
+            for (const Move& action : candidates)
+            {
+                if (action.type == GC::ATTACK) tryAction(action, depth, start);
+            }
+            return;
+        }
+
+        int attacker = start;
+        while (attacker < node.cards.size() and !isAttacker(node.cards[attacker])) attacker++;
+        if (attacker >= node.cards.size()) return;
+
+        tryAction(Move(GC::ATTACK, attacker, -1), depth, attacker + 1);
+        for (int i = 0; i < node.cards.size(); i++)
+        {
+            if (isEnemy(node.cards[i])) tryAction(Move(GC::ATTACK, attacker, i), depth, attacker + 1);
+        }
+        dfs(depth, attacker + 1);   // このCreatureでは攻撃しない
+    }
+
+    // 攻撃の手順を決めてnodeに適用し、その手順を返す
+    Strategy plan(GameNode& root)
+    {
+        node = root;
+        visited.clear();
+        path.clear();
+        bestPath.clear();
+        bestScore = -INF;
+
+        // 自分の時間制限か、ターンの持ち時間のうち呼び出し元のフェーズの分の早い方で打ち切る。
+        // これもtimeManagerのフェーズにしておくと、リプレイで本番と同じところで止まる
+        long long end = min(timeManager.phaseEnd, timeManager.elapsedMicros() + TIME_LIMIT);
+        timeManager.beginPhase((double)end / timeManager.budget);
+
+        dfs(0, 0);
+
+        Strategy strategy;
+        for (const Move& action : bestPath)
+        {
+            strategy.push_back(root.toOutputMove(action));
+            root.apply(action);
+        }
+        return strategy;
+    }
+};
+
+// historyに残っている親をたどって、nodeまでの行動列をstrategyに復元する (strategyの容量は使い回す)
+void restoreStrategy(const vector<GameNode>& history, int id, Strategy& strategy)
+{
+    strategy.clear();
+    for (int cur = id; history[cur].parent >= 0; cur = history[cur].parent)
+    {
+        strategy.push_back(history[cur].move);
+    }
+    reverse(strategy.begin(), strategy.end());
+}
+
+// SUMMON / USE / ATTACK の行動列に対するビームサーチ。
+// 時間が残っている限りビーム幅を倍にしながら探索し直し、最も評価値の高い行動列を返す。
+struct BattleSearch
+{
+    struct Candidate
+    {
+        int score;
+        int parent;
+        Move action;
+
+        bool operator>(const Candidate& c) const
+        {
+            return score > c.score;
+        }
+    };
+
+    // ビーム幅の上限。historyは1回の探索で高々1 + MAX_SEARCH_DEPTH * ビーム幅個になる
+    static const int MAX_BEAM_WIDTH = 2048;
+
+    vector<GameNode> history;   // 探索中に再確保されると大きなコピーで持ち時間を超えるので、探索前に確保しておく
+    vector<Candidate> candidates;
+    TranspositionTable table;   // 攻撃順が違うだけの同じ局面を除く
+    vector<int> beam, nextBeam;
+    FixedVector<Move, MAX_ACTIONS> actions;
+
+    int bestScore;
+    int bestId;     // 今回のrunで見つけた最善のhistoryの番号。なければ-1
+    Strategy bestStrategy;
+
+    // 1回分のビームサーチ。全候補がビームに収まった (= 全探索できた) ときtrueを返す
+    bool run(const GameNode& root, int beamWidth)
+    {
+        // 容量はターンをまたいで使い回し、足りないときだけ広げる
+        history.reserve(1 + MAX_SEARCH_DEPTH * beamWidth);
+
+        bestId = -1;
+        bool exhaustive = expand(root, beamWidth);
+        if (bestId >= 0) restoreStrategy(history, bestId, bestStrategy);
+        return exhaustive;
+    }
+
+    bool expand(const GameNode& root, int beamWidth)
+    {
+        bool exhaustive = true;
+
+        table.clear();
+        table.insert(root.hash);
+
+        history.clear();
+        history.push_back(root);
+        history[0].id = 0;
+        history[0].parent = -1;
+        beam.assign(1, 0);
+
+        for (int depth = 0; depth < MAX_SEARCH_DEPTH and !beam.empty(); depth++)
+        {
+            candidates.clear();
+            for (int id : beam)
+            {
+                if (timeManager.isOver()) return false;
+
+                // 候補の評価はコピーせずに、親の局面を進めて戻すだけで済ませる
+                GameNode& parent = history[id];
+                parent.legalActions(actions);
+                for (const Move& action : actions)
+                {
+                    Undo undo;
+                    if (!parent.apply(action, &undo)) continue;
+                    Stats::count(Stats::NODES);
+                    if (table.insert(parent.hash))
+                    {
+                        candidates.push_back(Candidate{ evaluateNode(parent), id, action });
+                    }
+                    parent.unmake(undo);
+                }
+            }
+
+            if ((int)candidates.size() > beamWidth)
+            {
+                exhaustive = false;
+                nth_element(candidates.begin(), candidates.begin() + beamWidth, candidates.end(),
+                            greater<Candidate>());
+                candidates.resize(beamWidth);
+            }
+
+            nextBeam.clear();
+            for (const Candidate& c : candidates)
+            {
+                if (timeManager.isOver()) return false;
+
+                GameNode child = history[c.parent];
+                child.apply(c.action);
+                child.id = history.size();
+                child.parent = c.parent;
+                child.score = c.score;
+                child.move = history[c.parent].toOutputMove(c.action);
+                history.push_back(child);
+                nextBeam.push_back(child.id);
+
+                if (c.score > bestScore)
+                {
+                    bestScore = c.score;
+                    bestId = child.id;
+                }
+            }
+            swap(beam, nextBeam);
+        }
+        return exhaustive;
+    }
+
+    // initialScoreは比較対象となる既存の行動列の評価値
+    // ターンの持ち時間が尽きるまで探索する
+    Strategy search(const GameNode& root, int initialScore, const Strategy& initialStrategy)
+    {
+        bestScore = initialScore;
+        bestStrategy = initialStrategy;
+
+        for (int width = INITIAL_BEAM_WIDTH; width <= MAX_BEAM_WIDTH and !timeManager.isOver(); width *= 2)
+        {
+            if (run(root, width)) break;
+        }
+        return bestStrategy;
+    }
+};
+
 Strategy battle(GameNode& node)
 {
     Strategy strategy;
@@ -762,16 +2118,34 @@ Strategy battle(GameNode& node)
     sort(node.cards.begin(), node.cards.end(),
          [&](const Card& c1, const Card& c2)
          {
-             return evaluateCreature(c1) < evaluateCreature(c2);
+             return CardDB::baseScore(c1) < CardDB::baseScore(c2);
          });
+    node.computeHash();
 
-    cerr << "summon start" << endl;
-    strategy = Util::concat(strategy, summon(node));
-    cerr << "greenItem start" << endl;
-    strategy = Util::concat(strategy, useGreenItem(node));
-    cerr << "attack start" << endl;
-    strategy = Util::concat(strategy, attack(node));
-    cerr << "finish" << endl;
+    // リーサルがあれば探索せずにそれを使う
+    static LethalSolver lethalSolver;
+    {
+        Stats::Scope scope(Stats::LETHAL);
+        if (lethalSolver.solve(node, strategy)) return strategy;
+    }
+
+    // 貪欲な行動列を基準にして、それより良いものを探索で探す
+    GameNode greedy = node;
+    timeManager.beginPhase(GREEDY_TIME_RATIO);
+    {
+        Stats::Scope scope(Stats::GREEDY);
+        strategy = Util::concat(strategy, summon(greedy));
+        strategy = Util::concat(strategy, useGreenItem(greedy));
+        static AttackPlanner attackPlanner;
+        strategy = Util::concat(strategy, attackPlanner.plan(greedy));
+    }
+
+    static BattleSearch searcher;
+    timeManager.beginPhase(1.0);
+    {
+        Stats::Scope scope(Stats::SEARCH);
+        strategy = searcher.search(node, evaluateNode(greedy), strategy);
+    }
 
     if (strategy.empty())
     {
@@ -788,35 +2162,164 @@ GameNode now;
 int roundNo = 0;
 bool isDraftPhase = true;
 
-bool gameUpdate()
+void nextRound()
 {
     if (roundNo >= 30)
     {
         isDraftPhase = false;
     }
+    roundNo++;
+}
 
+bool gameUpdate()
+{
     now = GameNode::input();
+    if (reader.failed) return false;
 
-    roundNo++;
+    nextRound();
+    timeManager.startTurn(reader.arrival, roundNo == 1);
+    return true;
 }
 
+Strategy think(GameNode& node)
+{
+    if (isDraftPhase)
+    {
+        return draft(node);
+    }
+    else
+    {
+        return battle(node);
+    }
+}
 
-int main()
+// リプレイログ。環境変数BOT_REPLAYにファイル名を指定すると、シードと毎ターンの
+// GameNode (trivially copyableなのでそのままのバイト列) と出力を書き出す。
+// 出力の記録には、フェーズごとに探索を打ち切ったところ (TimeManager::record) も含める。
+// ./main --replay FILE で、同じ入力・同じ乱数・同じ打ち切り位置でもう一度思考させられる。
+namespace Replay
 {
-    while (gameUpdate())
+    static const char MAGIC[4] = { 'L', 'R', 'P', '2' };
+    static const unsigned char INPUT = 1;
+    static const unsigned char OUTPUT = 2;  // 打ち切り位置の個数, 打ち切り位置..., 出力の文字列
+
+    FILE* log = nullptr;
+
+    void open()
+    {
+        const char* path = getenv("BOT_REPLAY");
+        if (path == nullptr or (log = fopen(path, "wb")) == nullptr) return;
+        fwrite(MAGIC, 1, sizeof(MAGIC), log);
+        fwrite(&Random::seed, sizeof(Random::seed), 1, log);
+    }
+
+    void write(unsigned char kind, const void* data, unsigned size)
+    {
+        if (log == nullptr) return;
+        fwrite(&kind, 1, 1, log);
+        fwrite(&size, sizeof(size), 1, log);
+        fwrite(data, 1, size, log);
+        if (kind == OUTPUT) fflush(log);
+    }
+
+    void writeOutput(const vector<int>& work, const string& output)
+    {
+        string data;
+        int count = work.size();
+        data.append(reinterpret_cast<const char*>(&count), sizeof(count));
+        data.append(reinterpret_cast<const char*>(work.data()), count * sizeof(int));
+        data += output;
+        write(OUTPUT, data.data(), data.size());
+    }
+
+    bool read(FILE* in, unsigned char& kind, string& data)
+    {
+        unsigned size;
+        if (fread(&kind, 1, 1, in) != 1 or fread(&size, sizeof(size), 1, in) != 1) return false;
+        data.resize(size);
+        return fread(&data[0], 1, size, in) == size;
+    }
+
+    bool readOutput(const string& data, vector<int>& work, string& output)
+    {
+        int count;
+        if (data.size() < sizeof(count)) return false;
+        memcpy(&count, data.data(), sizeof(count));
+        unsigned offset = sizeof(count) + count * sizeof(int);
+        if (count < 0 or data.size() < offset) return false;
+        work.resize(count);
+        memcpy(work.data(), data.data() + sizeof(count), count * sizeof(int));
+        output = data.substr(offset);
+        return true;
+    }
+
+    // ログの各ターンを、記録した打ち切り位置まで再実行し、かかった時間と記録された出力との違いを表示する
+    int run(const char* path)
     {
-        Strategy s;
-        if (isDraftPhase)
+        FILE* in = fopen(path, "rb");
+        char magic[4];
+        unsigned long long seed;
+        if (in == nullptr or fread(magic, 1, 4, in) != 4 or memcmp(magic, MAGIC, 4) != 0 or
+            fread(&seed, sizeof(seed), 1, in) != 1)
         {
-            s = draft(now);
+            cerr << "invalid replay file: " << path << endl;
+            return 1;
         }
-        else
+        Random::setSeed(seed);
+
+        unsigned char kind;
+        string data, logged;
+        vector<int> work;
+        while (read(in, kind, data))
         {
-            s = battle(now);
+            if (kind == INPUT and data.size() == sizeof(GameNode))
+            {
+                memcpy(&now, data.data(), sizeof(GameNode));
+                nextRound();
+                continue;
+            }
+            if (kind != OUTPUT or !readOutput(data, work, logged)) break;
+
+            Timer timer;
+            timeManager.replay(work);
+            timeManager.startTurn(timer, roundNo == 1);
+            Random::seedTurn(roundNo);
+            string result = toString(think(now));
+            long long elapsed = timer.elapsedMicros();
+
+            printf("turn %d  %lld us  output: %s\n", roundNo, elapsed, result.c_str());
+            printf("turn %d  logged: %s%s\n", roundNo, logged.c_str(), logged == result ? "" : "  (differs)");
+            fflush(stdout);
+            applyOutput(now, logged);
+            Stats::flush(roundNo);
         }
+        fclose(in);
+        return 0;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    Zobrist::init();
 
-        output(s);
+    if (argc >= 3 and string(argv[1]) == "--replay")
+    {
+        return Replay::run(argv[2]);
+    }
+    Replay::open();
+
+    while (gameUpdate())
+    {
+        Replay::write(Replay::INPUT, &now, sizeof(now));
+
+        Random::seedTurn(roundNo);
+        string res = toString(think(now));
+        Replay::writeOutput(timeManager.record(), res);
+        applyOutput(now, res);
+        cout << res << endl;
+        reader.nextTurn();
+        Stats::flush(roundNo);
     }
 
     return 0;
-}
\ No newline at end of file
+}
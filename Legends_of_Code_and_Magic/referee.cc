@@ -0,0 +1,729 @@
+// Legends of Code and Magic のローカル審判 + 並列自己対戦ランナー
+//
+// 使い方:
+//   ./referee [--games N] [--threads T] [--seed S] [--cards creature.txt] PLAYER1 PLAYER2
+//
+// PLAYERには "builtin:greedy" / "builtin:random" のような組み込み戦略か、
+// 標準入出力で対戦するボットを起動するシェルコマンド (例: ./main) を指定する。
+// 入力形式はmain.ccが読んでいる形式に合わせてある。
+// ボットのプロセスには試合ごとのシードを環境変数BOT_SEEDで渡すので、同じ--seedなら同じ試合を再現できる。
+// 応答の制限時間は最初の1回が1000ms、それ以降は100msで、超えたら負けになる。
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <array>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <cmath>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/wait.h>
+using namespace std;
+
+namespace GC
+{
+    // location
+    static const int MY_HAND = 0;
+    static const int MY_SIDE = 1;
+    static const int OP_SIDE = -1;
+
+    // card
+    static const int CREATURE = 0;
+    static const int GREEN_ITEM = 1;
+    static const int RED_ITEM = 2;
+    static const int BLUE_ITEM = 3;
+
+    // ability
+    static const char ABILITY_CHARS[] = "BCDGLW";
+    static const int ABILITY_COUNT = 6;
+    static const int BREAKTHROUGH = (1 << 0);
+    static const int CHARGE       = (1 << 1);
+    static const int DRAIN        = (1 << 2);
+    static const int GUARD        = (1 << 3);
+    static const int LETHAL       = (1 << 4);
+    static const int WARD         = (1 << 5);
+
+    static const int DRAFT_TURNS = 30;
+    static const int MAX_HAND = 8;
+    static const int MAX_BOARD = 6;
+    static const int MAX_MANA = 12;
+    static const int START_HEALTH = 30;
+    static const int RUNE_STEP = 5;
+    static const int MAX_TURNS = 200;   // これを超えたら引き分け
+
+    // [ms] 最初の応答とそれ以降の応答の制限時間。超えたら負け
+    static const int FIRST_RESPONSE_TIMEOUT = 1000;
+    static const int RESPONSE_TIMEOUT = 100;
+};
+
+//////////////////////////////////////// カード ////////////////////////////////////////
+
+struct Card
+{
+    int number;
+    int id;
+    int type;
+    int cost;
+    int attack;
+    int defense;
+    int abilities;
+    int myHealthChange;
+    int opponentHealthChange;
+    int cardDraw;
+    bool canAttack;
+
+    bool has(int ability) const { return abilities & ability; }
+
+    string abilityString() const
+    {
+        string s(GC::ABILITY_COUNT, '-');
+        for (int i = 0; i < GC::ABILITY_COUNT; i++)
+        {
+            if (abilities & (1 << i)) s[i] = GC::ABILITY_CHARS[i];
+        }
+        return s;
+    }
+};
+
+string trim(const string& s)
+{
+    int l = 0, r = s.size();
+    while (l < r and isspace(s[l])) l++;
+    while (r > l and isspace(s[r - 1])) r--;
+    return s.substr(l, r - l);
+}
+
+// creature.txt ("id ; name ; type ; cost ; damage ; health ; abilities ; playerHP ; enemyHP ; draw ; text")
+vector<Card> loadCards(const string& path)
+{
+    vector<Card> cards;
+    ifstream ifs(path);
+    string line;
+
+    while (getline(ifs, line))
+    {
+        vector<string> record;
+        stringstream ss(line);
+        string token;
+        while (getline(ss, token, ';')) record.push_back(trim(token));
+        if (record.size() < 10) continue;
+
+        Card card = {};
+        card.number = stoi(record[0]);
+        card.id = -1;
+        if (record[2] == "itemGreen") card.type = GC::GREEN_ITEM;
+        else if (record[2] == "itemRed") card.type = GC::RED_ITEM;
+        else if (record[2] == "itemBlue") card.type = GC::BLUE_ITEM;
+        else card.type = GC::CREATURE;
+        card.cost = stoi(record[3]);
+        card.attack = stoi(record[4]);
+        card.defense = stoi(record[5]);
+        for (int i = 0; i < GC::ABILITY_COUNT and i < (int)record[6].size(); i++)
+        {
+            if (record[6][i] != '-') card.abilities |= (1 << i);
+        }
+        card.myHealthChange = stoi(record[7]);
+        card.opponentHealthChange = stoi(record[8]);
+        card.cardDraw = stoi(record[9]);
+        cards.push_back(card);
+    }
+    return cards;
+}
+
+//////////////////////////////////////// ゲーム ////////////////////////////////////////
+
+struct Player
+{
+    int health;
+    int mana;
+    int maxMana;
+    int nextRune;
+    int extraDraws;
+    vector<Card> deck, hand, board;
+};
+
+struct Game
+{
+    const vector<Card>& pool;
+    mt19937 mt;
+    Player players[2];
+    array<Card, 3> choices;
+    bool isDraftPhase;
+    int turn;
+    int nextID;
+
+    Game(const vector<Card>& pool, unsigned seed) : pool(pool), mt(seed), isDraftPhase(true), turn(0), nextID(1)
+    {
+        for (Player& p : players)
+        {
+            p.health = GC::START_HEALTH;
+            p.mana = p.maxMana = 0;
+            p.nextRune = GC::START_HEALTH - GC::RUNE_STEP;
+            p.extraDraws = 0;
+        }
+    }
+
+    void dealChoices()
+    {
+        for (Card& card : choices) card = pool[mt() % pool.size()];
+    }
+
+    void pick(int player, int index)
+    {
+        if (index < 0 or index >= 3) index = 0;
+        Card card = choices[index];
+        card.id = nextID++;
+        players[player].deck.push_back(card);
+    }
+
+    void draw(int player)
+    {
+        Player& p = players[player];
+        if (p.deck.empty())
+        {
+            // 山札切れは次のルーンまで体力を失う
+            p.health = min(p.health, p.nextRune);
+            checkRunes(player);
+            return;
+        }
+        Card card = p.deck.back();
+        p.deck.pop_back();
+        if (p.hand.size() < GC::MAX_HAND) p.hand.push_back(card);
+    }
+
+    // 体力がルーンを下回るごとに次のターンのドローが1枚増える
+    void checkRunes(int player)
+    {
+        Player& p = players[player];
+        while (p.nextRune > 0 and p.health <= p.nextRune)
+        {
+            p.nextRune -= GC::RUNE_STEP;
+            p.extraDraws++;
+        }
+    }
+
+    void startBattle()
+    {
+        isDraftPhase = false;
+        for (Player& p : players) shuffle(p.deck.begin(), p.deck.end(), mt);
+        for (int i = 0; i < 4; i++) draw(0);
+        for (int i = 0; i < 5; i++) draw(1);
+    }
+
+    void startTurn(int player)
+    {
+        Player& p = players[player];
+        p.maxMana = min(GC::MAX_MANA, p.maxMana + 1);
+        p.mana = p.maxMana;
+
+        int draws = 1 + p.extraDraws;
+        p.extraDraws = 0;
+        for (int i = 0; i < draws; i++) draw(player);
+        for (Card& card : p.board) card.canAttack = true;
+    }
+
+    int winner() const
+    {
+        if (players[0].health <= 0) return 1;
+        if (players[1].health <= 0) return 0;
+        return -1;
+    }
+
+    void damage(int player, int amount)
+    {
+        if (amount <= 0) return;
+        players[player].health -= amount;
+        checkRunes(player);
+    }
+
+    void heal(int player, int amount)
+    {
+        if (amount > 0) players[player].health += amount;
+        else damage(player, -amount);
+    }
+
+    static int find(const vector<Card>& cards, int id)
+    {
+        for (int i = 0; i < (int)cards.size(); i++) if (cards[i].id == id) return i;
+        return -1;
+    }
+
+    static bool hasGuard(const vector<Card>& board)
+    {
+        for (const Card& card : board) if (card.has(GC::GUARD)) return true;
+        return false;
+    }
+
+    // creatureにdamageを与え、実際に与えたダメージを返す
+    static int dealDamage(Card& creature, int damage, bool lethal)
+    {
+        if (damage <= 0) return 0;
+        if (creature.has(GC::WARD))
+        {
+            creature.abilities &= ~GC::WARD;
+            return 0;
+        }
+        int dealt = min(damage, creature.defense);
+        creature.defense -= damage;
+        if (lethal) creature.defense = 0;
+        return dealt;
+    }
+
+    static void removeDead(vector<Card>& board)
+    {
+        board.erase(remove_if(board.begin(), board.end(), [](const Card& c) { return c.defense <= 0; }),
+                    board.end());
+    }
+
+    void summon(int player, int id)
+    {
+        Player& p = players[player];
+        int idx = find(p.hand, id);
+        if (idx < 0 or p.hand[idx].type != GC::CREATURE) return;
+        if (p.hand[idx].cost > p.mana or p.board.size() >= GC::MAX_BOARD) return;
+
+        Card card = p.hand[idx];
+        p.hand.erase(p.hand.begin() + idx);
+        p.mana -= card.cost;
+        card.canAttack = card.has(GC::CHARGE);
+        p.board.push_back(card);
+
+        heal(player, card.myHealthChange);
+        heal(1 - player, card.opponentHealthChange);
+        p.extraDraws += card.cardDraw;
+    }
+
+    void attack(int player, int attackerID, int targetID)
+    {
+        Player &p = players[player],
+               &op = players[1 - player];
+        int a = find(p.board, attackerID);
+        if (a < 0 or !p.board[a].canAttack) return;
+        Card& attacker = p.board[a];
+
+        if (targetID < 0)
+        {
+            if (hasGuard(op.board)) return;
+            attacker.canAttack = false;
+            damage(1 - player, attacker.attack);
+            if (attacker.has(GC::DRAIN)) heal(player, attacker.attack);
+            return;
+        }
+
+        int t = find(op.board, targetID);
+        if (t < 0) return;
+        Card& target = op.board[t];
+        if (!target.has(GC::GUARD) and hasGuard(op.board)) return;
+
+        attacker.canAttack = false;
+        int defense = target.has(GC::WARD) ? 0 : target.defense;
+        int dealt = dealDamage(target, attacker.attack, attacker.has(GC::LETHAL));
+        dealDamage(attacker, target.attack, target.has(GC::LETHAL));
+
+        if (attacker.has(GC::DRAIN)) heal(player, dealt);
+        if (attacker.has(GC::BREAKTHROUGH) and dealt > 0) damage(1 - player, attacker.attack - defense);
+
+        removeDead(p.board);
+        removeDead(op.board);
+    }
+
+    void use(int player, int itemID, int targetID)
+    {
+        Player &p = players[player],
+               &op = players[1 - player];
+        int idx = find(p.hand, itemID);
+        if (idx < 0 or p.hand[idx].type == GC::CREATURE or p.hand[idx].cost > p.mana) return;
+        Card item = p.hand[idx];
+
+        if (item.type == GC::GREEN_ITEM)
+        {
+            int t = find(p.board, targetID);
+            if (t < 0) return;
+            p.board[t].attack += item.attack;
+            p.board[t].defense += item.defense;
+            p.board[t].abilities |= item.abilities;
+        }
+        else if (targetID >= 0 or item.type == GC::RED_ITEM)
+        {
+            int t = find(op.board, targetID);
+            if (t < 0) return;
+            Card& target = op.board[t];
+            target.abilities &= ~item.abilities;
+            target.attack = max(0, target.attack + item.attack);
+            if (item.defense < 0) dealDamage(target, -item.defense, false);
+            removeDead(op.board);
+        }
+        else
+        {
+            damage(1 - player, -item.defense);
+        }
+
+        p.hand.erase(p.hand.begin() + idx);
+        p.mana -= item.cost;
+        heal(player, item.myHealthChange);
+        heal(1 - player, item.opponentHealthChange);
+        p.extraDraws += item.cardDraw;
+    }
+
+    // "SUMMON 3; ATTACK 3 -1; ..." を順に適用する。不正な行動は無視する
+    void applyActions(int player, const string& output)
+    {
+        stringstream actions(output);
+        string action;
+        while (getline(actions, action, ';') and winner() < 0)
+        {
+            stringstream ss(action);
+            string type;
+            int target1 = -1, target2 = -1;
+            ss >> type >> target1 >> target2;
+
+            if (type == "SUMMON") summon(player, target1);
+            else if (type == "ATTACK") attack(player, target1, target2);
+            else if (type == "USE") use(player, target1, target2);
+        }
+    }
+
+    static void writeCard(ostream& os, const Card& card, int location)
+    {
+        os << card.number << " " << card.id << " " << location << " " << card.type << " "
+           << card.cost << " " << card.attack << " " << card.defense << " " << card.abilityString() << " "
+           << card.myHealthChange << " " << card.opponentHealthChange << " " << card.cardDraw << "\n";
+    }
+
+    // main.ccのGameNode::inputが読む形式の入力
+    string formatInput(int player) const
+    {
+        const Player &p = players[player],
+                     &op = players[1 - player];
+        ostringstream os;
+        os << p.health << " " << p.mana << " " << p.deck.size() << " " << p.nextRune << "\n";
+        os << op.health << " " << op.mana << " " << op.deck.size() << " " << op.nextRune << "\n";
+        os << op.hand.size() << "\n";
+
+        if (isDraftPhase)
+        {
+            os << 3 << "\n";
+            for (const Card& card : choices) writeCard(os, card, GC::MY_HAND);
+            return os.str();
+        }
+
+        os << p.hand.size() + p.board.size() + op.board.size() << "\n";
+        for (const Card& card : p.hand) writeCard(os, card, GC::MY_HAND);
+        for (const Card& card : p.board) writeCard(os, card, GC::MY_SIDE);
+        for (const Card& card : op.board) writeCard(os, card, GC::OP_SIDE);
+        return os.str();
+    }
+};
+
+//////////////////////////////////////// プレイヤー ////////////////////////////////////////
+
+struct Bot
+{
+    virtual ~Bot() {}
+    // 応答がない・プロセスが落ちたときはfalse
+    virtual bool ask(const Game& game, int player, string& output) = 0;
+};
+
+// 標準入出力でやり取りする外部プロセスのボット。
+// 試合を再現できるように、シードを環境変数BOT_SEEDで渡す
+struct ProcessBot : Bot
+{
+    pid_t pid;
+    int toBot, fromBot;
+    string buffer;
+    bool answered;  // 1度でも応答したか (最初の応答だけ制限時間が長い)
+
+    ProcessBot(const string& command, unsigned seed) : pid(-1), toBot(-1), fromBot(-1), answered(false)
+    {
+        // fork後の子プロセスではメモリ確保を避けたいので、コマンドは先に組み立てておく
+        string shell = "export BOT_SEED=" + to_string(seed) + "; " + command;
+        int in[2], out[2];
+        if (pipe(in) < 0 or pipe(out) < 0) return;
+
+        pid = fork();
+        if (pid == 0)
+        {
+            dup2(in[0], 0);
+            dup2(out[1], 1);
+            int devnull = open("/dev/null", O_WRONLY);
+            if (devnull >= 0) dup2(devnull, 2);     // デバッグ出力は捨てる
+            close(in[0]); close(in[1]); close(out[0]); close(out[1]);
+            execl("/bin/sh", "sh", "-c", shell.c_str(), (char*)nullptr);
+            _exit(127);
+        }
+        close(in[0]);
+        close(out[1]);
+        toBot = in[1];
+        fromBot = out[0];
+    }
+
+    ~ProcessBot()
+    {
+        if (toBot >= 0) close(toBot);
+        if (fromBot >= 0) close(fromBot);
+        if (pid > 0)
+        {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+        }
+    }
+
+    // timeout [ms] 以内に1行読めなければfalse
+    bool readLine(string& line, int timeout)
+    {
+        auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout);
+        while (true)
+        {
+            size_t pos = buffer.find('\n');
+            if (pos != string::npos)
+            {
+                line = buffer.substr(0, pos);
+                buffer.erase(0, pos + 1);
+                return true;
+            }
+
+            auto remaining = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+            pollfd fd = { fromBot, POLLIN, 0 };
+            if (remaining <= 0 or poll(&fd, 1, (int)remaining) <= 0) return false;
+
+            char chunk[4096];
+            ssize_t n = read(fromBot, chunk, sizeof(chunk));
+            if (n <= 0) return false;
+            buffer.append(chunk, n);
+        }
+    }
+
+    bool ask(const Game& game, int player, string& output) override
+    {
+        if (pid <= 0) return false;
+        string input = game.formatInput(player);
+        if (write(toBot, input.data(), input.size()) != (ssize_t)input.size()) return false;
+        int timeout = answered ? GC::RESPONSE_TIMEOUT : GC::FIRST_RESPONSE_TIMEOUT;
+        answered = true;
+        return readLine(output, timeout);
+    }
+};
+
+// プロセスを起動せずに同じプロセス内で動く簡単な戦略
+struct BuiltinBot : Bot
+{
+    bool randomPlay;
+    mt19937 mt;
+
+    BuiltinBot(bool randomPlay, unsigned seed) : randomPlay(randomPlay), mt(seed) {}
+
+    static int value(const Card& card)
+    {
+        return card.attack + card.defense + 2 * __builtin_popcount(card.abilities) - card.cost;
+    }
+
+    bool ask(const Game& game, int player, string& output) override
+    {
+        if (game.isDraftPhase)
+        {
+            int best = 0;
+            for (int i = 1; i < 3; i++)
+            {
+                if (value(game.choices[i]) > value(game.choices[best])) best = i;
+            }
+            output = "PICK " + to_string(randomPlay ? (int)(mt() % 3) : best);
+            return true;
+        }
+
+        const Player &p = game.players[player],
+                     &op = game.players[1 - player];
+        ostringstream os;
+        os << "PASS";
+
+        // 重いものから召喚できるだけ召喚する
+        vector<Card> hand = p.hand;
+        if (randomPlay) shuffle(hand.begin(), hand.end(), mt);
+        else sort(hand.begin(), hand.end(), [](const Card& a, const Card& b) { return a.cost > b.cost; });
+
+        int mana = p.mana, boardSize = p.board.size();
+        vector<Card> attackers;
+        for (const Card& card : p.board) if (card.canAttack) attackers.push_back(card);
+        for (const Card& card : hand)
+        {
+            if (card.type != GC::CREATURE or card.cost > mana or boardSize >= GC::MAX_BOARD) continue;
+            mana -= card.cost;
+            boardSize++;
+            os << ";SUMMON " << card.id;
+            if (card.has(GC::CHARGE)) attackers.push_back(card);
+        }
+
+        // Guard持ちに攻撃を集中させ、残りは顔へ
+        vector<Card> guards;
+        for (const Card& card : op.board) if (card.has(GC::GUARD)) guards.push_back(card);
+        for (const Card& attacker : attackers)
+        {
+            if (!guards.empty())
+            {
+                Card& guard = guards.front();
+                os << ";ATTACK " << attacker.id << " " << guard.id;
+                if (!guard.has(GC::WARD)) guard.defense -= attacker.attack;
+                guard.abilities &= ~GC::WARD;
+                if (guard.defense <= 0 or attacker.has(GC::LETHAL)) guards.erase(guards.begin());
+            }
+            else if (randomPlay and !op.board.empty() and mt() % 2)
+            {
+                os << ";ATTACK " << attacker.id << " " << op.board[mt() % op.board.size()].id;
+            }
+            else
+            {
+                os << ";ATTACK " << attacker.id << " -1";
+            }
+        }
+        output = os.str();
+        return true;
+    }
+};
+
+unique_ptr<Bot> makeBot(const string& spec, unsigned seed)
+{
+    if (spec == "builtin:greedy") return unique_ptr<Bot>(new BuiltinBot(false, seed));
+    if (spec == "builtin:random") return unique_ptr<Bot>(new BuiltinBot(true, seed));
+    return unique_ptr<Bot>(new ProcessBot(spec, seed));
+}
+
+//////////////////////////////////////// 対戦 ////////////////////////////////////////
+
+struct GameResult
+{
+    int winner;     // 0 or 1、引き分けは-1
+    int turns;
+};
+
+// bots[i]が席iに座る。応答できなかったプレイヤーは負け
+GameResult playGame(const vector<Card>& pool, unsigned seed, Bot* bots[2])
+{
+    Game game(pool, seed);
+
+    for (int draft = 0; draft < GC::DRAFT_TURNS; draft++)
+    {
+        game.dealChoices();
+        for (int player = 0; player < 2; player++)
+        {
+            string output;
+            if (!bots[player]->ask(game, player, output)) return GameResult{ 1 - player, 0 };
+
+            int index = 0;
+            sscanf(output.c_str(), "PICK %d", &index);
+            game.pick(player, index);
+        }
+    }
+
+    game.startBattle();
+    for (game.turn = 0; game.turn < GC::MAX_TURNS; game.turn++)
+    {
+        int player = game.turn % 2;
+        game.startTurn(player);
+        if (game.winner() >= 0) break;
+
+        string output;
+        if (!bots[player]->ask(game, player, output)) return GameResult{ 1 - player, game.turn };
+        game.applyActions(player, output);
+        if (game.winner() >= 0) break;
+    }
+    return GameResult{ game.winner(), game.turn };
+}
+
+struct Options
+{
+    int games = 100;
+    int threads = max(1u, thread::hardware_concurrency());
+    unsigned seed = 1;
+    string cards = "creature.txt";
+    string players[2];
+};
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    int positional = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--games" and i + 1 < argc) opt.games = stoi(argv[++i]);
+        else if (arg == "--threads" and i + 1 < argc) opt.threads = stoi(argv[++i]);
+        else if (arg == "--seed" and i + 1 < argc) opt.seed = stoul(argv[++i]);
+        else if (arg == "--cards" and i + 1 < argc) opt.cards = argv[++i];
+        else if (positional < 2) opt.players[positional++] = arg;
+    }
+    if (positional < 2)
+    {
+        cerr << "usage: " << argv[0] << " [--games N] [--threads T] [--seed S] [--cards FILE] PLAYER1 PLAYER2" << endl;
+        return 1;
+    }
+
+    vector<Card> pool = loadCards(opt.cards);
+    if (pool.empty())
+    {
+        cerr << "no cards loaded from " << opt.cards << endl;
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    // 先手・後手の偏りを消すため、同じシードで席を入れ替えた2試合を続けて行う
+    atomic<int> nextGame(0);
+    mutex mtx;
+    int wins = 0, losses = 0, draws = 0;
+    long long totalTurns = 0;
+
+    auto worker = [&]()
+    {
+        int g;
+        while ((g = nextGame++) < opt.games)
+        {
+            unsigned seed = opt.seed + g / 2;
+            int seatOfPlayer1 = g % 2;
+
+            unique_ptr<Bot> player1 = makeBot(opt.players[0], seed * 2),
+                            player2 = makeBot(opt.players[1], seed * 2 + 1);
+            Bot* bots[2];
+            bots[seatOfPlayer1] = player1.get();
+            bots[1 - seatOfPlayer1] = player2.get();
+
+            GameResult result = playGame(pool, seed, bots);
+
+            lock_guard<mutex> lock(mtx);
+            totalTurns += result.turns;
+            if (result.winner < 0) draws++;
+            else if (result.winner == seatOfPlayer1) wins++;
+            else losses++;
+        }
+    };
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int i = 0; i < opt.threads; i++) threads.emplace_back(worker);
+    for (thread& t : threads) t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // 引き分けを0.5勝として、勝率の95%信頼区間をWilsonの方法で求める
+    int n = wins + losses + draws;
+    double p = (wins + 0.5 * draws) / n,
+           z = 1.96,
+           center = (p + z * z / (2 * n)) / (1 + z * z / n),
+           margin = z * sqrt(p * (1 - p) / n + z * z / (4.0 * n * n)) / (1 + z * z / n);
+
+    printf("player1: %s\nplayer2: %s\n", opt.players[0].c_str(), opt.players[1].c_str());
+    printf("games: %d  wins: %d  losses: %d  draws: %d\n", n, wins, losses, draws);
+    printf("win rate: %.2f%%  95%% CI: [%.2f%%, %.2f%%]\n",
+           100 * p, 100 * (center - margin), 100 * (center + margin));
+    printf("avg turns: %.1f  throughput: %.1f games/s (%d threads, %.2f s)\n",
+           (double)totalTurns / n, n / seconds, opt.threads, seconds);
+
+    return 0;
+}
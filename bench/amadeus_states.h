@@ -0,0 +1,35 @@
+// Amadeus Challengeのベンチマーク・検査で使う入力と局面 (main.ccの後にincludeする)
+#pragma once
+
+// 決まった乱数で、惑星90個・辺180本のゲーム定数と1ターン分の入力を作る
+string makeConstantsText() {
+    mt19937 mt(2018);
+    string text = to_string(MAX_PLANET_COUNT) + " 180\n";
+    for (int i = 0; i < 180; i++) {
+        int a = i % MAX_PLANET_COUNT,
+            b = (a + 1 + mt() % (MAX_PLANET_COUNT - 1)) % MAX_PLANET_COUNT;
+        text += to_string(a) + " " + to_string(b) + "\n";
+    }
+    return text;
+}
+
+string makeTurnText(int seed = 828) {
+    mt19937 mt(seed);
+    string text;
+    for (int i = 0; i < MAX_PLANET_COUNT; i++) {
+        text += to_string(mt() % 30) + " " + to_string(mt() % 6) + " " +
+                to_string(mt() % 30) + " " + to_string(mt() % 6) + " " + to_string(mt() % 2) + "\n";
+    }
+    return text;
+}
+
+// 決まった乱数で作った入力を読み、count個の局面を作る
+vector<GameState> makeStates(int count) {
+    vector<GameState> states;
+    for (int i = 0; i < count; i++) {
+        string turn = makeTurnText(i);
+        reader.load(turn.data(), turn.size());
+        states.push_back(inputPlanets());
+    }
+    return states;
+}
@@ -0,0 +1,63 @@
+// ボットのホットパスを測るための小さなベンチマークハーネス。
+// ウォームアップの後に同じ処理を何回か繰り返し、1回あたりの時間の中央値・最小値・標準偏差を表示する。
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace Bench {
+
+const int WARMUP_ROUNDS = 3;
+const int REPETITIONS   = 15;
+const double MIN_SAMPLE_NS = 1e6;   // 1回の計測がこれより短いと時計の誤差が目立つので、まとめて測る
+
+// 最適化で計算ごと消されないように、値を使ったことにする
+template<class T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void header() {
+    printf("%-40s %12s %12s %10s\n", "benchmark", "median ns/op", "min ns/op", "stddev %");
+}
+
+// body()を1回呼ぶとopsPerRound回分の処理をするものとして、1回あたりの時間を測る
+template<class F>
+double measure(F& body, int rounds) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) body();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<class F>
+void run(const char* name, long long opsPerRound, F body) {
+    // ウォームアップしながら、1回の計測でbody()を何回呼ぶかを決める
+    int rounds = 1;
+    for (int i = 0; i < WARMUP_ROUNDS; i++) {
+        double elapsed = measure(body, rounds);
+        while (elapsed * 2 < MIN_SAMPLE_NS) {
+            rounds *= 2;
+            elapsed *= 2;
+        }
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < REPETITIONS; i++) {
+        samples.push_back(measure(body, rounds) / (opsPerRound * rounds));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    double mean = 0, variance = 0;
+    for (double s : samples) mean += s;
+    mean /= samples.size();
+    for (double s : samples) variance += (s - mean) * (s - mean);
+    variance /= samples.size();
+
+    double median = samples[samples.size() / 2];
+    printf("%-40s %12.1f %12.1f %10.1f\n", name, median, samples[0], 100.0 * std::sqrt(variance) / mean);
+}
+
+}  // namespace Bench
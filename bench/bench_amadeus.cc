@@ -0,0 +1,130 @@
+// Amadeus Challengeのベンチマーク
+#define main amadeus_main
+#include "../Amadeus_Challenge/main.cc"
+#undef main
+
+#include <sstream>
+#include "bench.h"
+#include "amadeus_states.h"
+
+// 以前のcin >>による読み込みと同じことをistringstreamで行う (比較用)
+GameState inputPlanetsByStream(istream& in) {
+    GameState state;
+    for (int i = 0; i < planetCount; i++) {
+        in >> state.myUnits[i] >> state.myTolerance[i]
+           >> state.otherUnits[i] >> state.otherTolerance[i] >> state.canAssign[i];
+    }
+    return state;
+}
+
+void benchParse() {
+    const int TURNS = 10000;
+    string turn = makeTurnText();
+
+    Bench::run("amadeus/parse turn (Reader)", TURNS, [&]() {
+        for (int i = 0; i < TURNS; i++) {
+            reader.load(turn.data(), turn.size());
+            GameState state = inputPlanets();
+            Bench::doNotOptimize(state.myUnits[0]);
+        }
+    });
+    Bench::run("amadeus/parse turn (istringstream)", TURNS, [&]() {
+        for (int i = 0; i < TURNS; i++) {
+            istringstream in(turn);
+            GameState state = inputPlanetsByStream(in);
+            Bench::doNotOptimize(state.myUnits[0]);
+        }
+    });
+}
+
+void benchGameState() {
+    auto states = makeStates(16);
+
+    // 全惑星へのNORMALと、5体以上いる惑星からのUNIT_SPREAD
+    vector<pair<int, Move>> moves;
+    for (int i = 0; i < (int)states.size(); i++) {
+        for (int id = 0; id < planetCount; id++) {
+            moves.emplace_back(i, Move(NORMAL, id));
+            if (states[i].myUnits[id] >= 5) moves.emplace_back(i, Move(UNIT_SPREAD, id));
+        }
+    }
+
+    Bench::run("amadeus/advanceGameState", moves.size(), [&]() {
+        for (auto& m : moves) {
+            GameState next = advanceGameState(states[m.first], m.second);
+            Bench::doNotOptimize(next.myUnits[0]);
+        }
+    });
+    Bench::run("amadeus/GameState::apply + undo", moves.size(), [&]() {
+        for (auto& m : moves) {
+            GameState& state = states[m.first];
+            StateUndo undo;
+            state.apply(m.second, &undo);
+            Bench::doNotOptimize(state.total);
+            state.undo(m.second, undo);
+        }
+    });
+    Bench::run("amadeus/evaluatePlanets", states.size(), [&]() {
+        for (auto& state : states) {
+            auto scores = evaluatePlanets(state);
+            Bench::doNotOptimize(scores[0]);
+        }
+    });
+    Bench::run("amadeus/evaluateGameState", states.size(), [&]() {
+        int sum = 0;
+        for (auto& state : states) sum += evaluateGameState(state);
+        Bench::doNotOptimize(sum);
+    });
+}
+
+// 自分の候補16個 × 相手の行動のサンプル64個を、1ターン後の局面まで進めて評価する
+void benchResolveTurn() {
+    auto states = makeStates(4);
+    setSeed(1);
+
+    vector<vector<TurnPlan>> mine(states.size()), theirs(states.size());
+    OpponentModel opponent;
+    for (int i = 0; i < (int)states.size(); i++) {
+        opponent.prepare(states[i]);
+        for (int k = 0; k < 64; k++) theirs[i].push_back(opponent.sample(states[i], k == 0));
+        for (int k = 0; k < 16; k++) {
+            TurnPlan plan;
+            for (int j = 0; j < PLACEMENT_COUNT; j++) plan.targets[j] = randInt(planetCount);
+            plan.spread = -1;
+            mine[i].push_back(plan);
+        }
+    }
+
+    Bench::run("amadeus/OpponentModel::sample", 64 * states.size(), [&]() {
+        for (auto& state : states) {
+            opponent.prepare(state);
+            for (int k = 0; k < 64; k++) {
+                TurnPlan plan = opponent.sample(state, false);
+                Bench::doNotOptimize(plan.targets[0]);
+            }
+        }
+    });
+    Bench::run("amadeus/resolveTurn + evaluate", 16 * 64 * states.size(), [&]() {
+        int sum = 0;
+        for (int i = 0; i < (int)states.size(); i++) {
+            for (auto& a : mine[i]) {
+                for (auto& b : theirs[i]) {
+                    sum += resolveTurn(states[i], a, b);
+                }
+            }
+        }
+        Bench::doNotOptimize(sum);
+    });
+}
+
+int main() {
+    string constants = makeConstantsText();
+    reader.load(constants.data(), constants.size());
+    inputGameConstants();
+
+    Bench::header();
+    benchParse();
+    benchGameState();
+    benchResolveTurn();
+    return 0;
+}
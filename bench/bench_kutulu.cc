@@ -0,0 +1,120 @@
+// Code of Kutuluのベンチマーク
+#define main kutulu_main
+#include "../Code_of_Kutulu/main.cc"
+#undef main
+
+#include <sstream>
+#include "bench.h"
+#include "kutulu_input.h"
+#include "kutulu_bitboard.h"
+
+// 以前のcin >>による読み込みと同じことをistringstreamで行う (比較用)
+vector<Entity> inputEntitiesByStream(istream& in) {
+    int entityCount;
+    in >> entityCount;
+
+    vector<Entity> entities;
+    for (int i = 0; i < entityCount; i++) {
+        string entityType;
+        int id, x, y, param0, param1, param2;
+        in >> entityType >> id >> x >> y >> param0 >> param1 >> param2;
+        entities.emplace_back(parseEntityType(entityType.c_str()), id, x, y, param0, param1, param2);
+    }
+    return entities;
+}
+
+void benchParse() {
+    const int TURNS = 10000;
+
+    Bench::run("kutulu/parse turn (Reader)", TURNS, [&]() {
+        for (int i = 0; i < TURNS; i++) {
+            reader.load(TURN, sizeof(TURN) - 1);
+            auto entities = inputEntities();
+            Bench::doNotOptimize(entities[0].x);
+        }
+    });
+    Bench::run("kutulu/parse turn (istringstream)", TURNS, [&]() {
+        for (int i = 0; i < TURNS; i++) {
+            istringstream in(TURN);
+            auto entities = inputEntitiesByStream(in);
+            Bench::doNotOptimize(entities[0].x);
+        }
+    });
+}
+
+void benchDistance() {
+    Bench::run("kutulu/buildDistanceTable", 1, [&]() {
+        buildDistanceTable();
+        Bench::doNotOptimize(distanceTable[0]);
+    });
+
+    // 壁でない全てのマスの組
+    Bench::run("kutulu/calcDistance (table)", (long long)cellCount * cellCount, [&]() {
+        int sum = 0;
+        for (int a = 0; a < cellCount; a++) {
+            for (int b = 0; b < cellCount; b++) sum += calcDistance(cellX[a], cellY[a], cellX[b], cellY[b]);
+        }
+        Bench::doNotOptimize(sum);
+    });
+
+    // 壁でない全てのマスから、bitboardで幅優先探索する
+    static BitBoard layers[MAX_CELLS];
+    Bench::run("kutulu/distanceLayers (bitboard)", cellCount, [&]() {
+        int sum = 0;
+        for (int a = 0; a < cellCount; a++) {
+            BitBoard from;
+            from.set(cellX[a], cellY[a]);
+            sum += distanceLayers(from, layers, MAX_CELLS);
+        }
+        Bench::doNotOptimize(sum);
+    });
+    Bench::run("kutulu/withinSteps 5 (bitboard)", cellCount, [&]() {
+        int sum = 0;
+        for (int a = 0; a < cellCount; a++) {
+            BitBoard from;
+            from.set(cellX[a], cellY[a]);
+            sum += withinSteps(from, 5).w[0] != 0;
+        }
+        Bench::doNotOptimize(sum);
+    });
+}
+
+// TURNの局面から自分の行動をランダムに選んで20ターンずつ進める
+void benchSimulator() {
+    const int TURNS = 20;
+    reader.load(TURN, sizeof(TURN) - 1);
+    auto entities = inputEntities();
+    Node root(entities, 0, 0);
+    setSeed(1);
+
+    Bench::run("kutulu/Simulator::step + evaluate", TURNS, [&]() {
+        Node node = root;
+        Action actions[8];
+        int score = 0;
+        for (int i = 0; i < TURNS; i++) {
+            Simulator(&node).step(actions[randInt(listActions(node, actions))]);
+            score += Evaluator(&node).evaluate();
+        }
+        Bench::doNotOptimize(score);
+    });
+
+    // 持ち時間を気にせずSEARCH_DEPTHまで読み切る
+    timeManager = TimeManager(3600LL * 1000 * 1000, 3600LL * 1000 * 1000);
+    Bench::run("kutulu/BeamSearch::search (no time limit)", 1, [&]() {
+        timeManager.startTurn(Timer(), true);
+        Action action = beamSearch.search(root);
+        Bench::doNotOptimize(action.type);
+    });
+}
+
+int main() {
+    reader.load(CONSTANTS, sizeof(CONSTANTS) - 1);
+    inputGameConstant();
+    buildMazeBoards();
+
+    Bench::header();
+    benchParse();
+    benchDistance();
+    benchSimulator();
+    return 0;
+}
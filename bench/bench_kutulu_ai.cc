@@ -0,0 +1,47 @@
+// Code of Kutuluのai.cpp (Wandererまでの距離) のベンチマーク
+#define main ai_main
+#include "../Code_of_Kutulu/ai.cpp"
+#undef main
+
+#include "bench.h"
+#include "kutulu_input.h"
+
+int main() {
+    reader.load(CONSTANTS, sizeof(CONSTANTS) - 1);
+    width  = reader.readInt();
+    height = reader.readInt();
+    map.assign(width, "");
+    for (int y = 0; y < height; y++) {
+        char row[32];
+        reader.readToken(row, sizeof(row));
+        for (int x = 0; x < width; x++) map[x].push_back(row[x]);
+    }
+
+    reader.load(TURN, sizeof(TURN) - 1);
+    std::vector<Entity> entities(reader.readInt());
+    for (auto& e : entities) e = Entity::input();
+
+    // 壁以外の全マスから最寄りのWandererまでの距離を求める
+    std::vector<std::pair<int, int>> cells;
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            if (map[x][y] != '#') cells.emplace_back(x, y);
+        }
+    }
+
+    Bench::header();
+    Bench::run("kutulu/buildWandererDistance", 1, [&]() {
+        buildWandererDistance(entities);
+        Bench::doNotOptimize(wandererDistance[0]);
+    });
+    Bench::run("kutulu/nearestWanderer", cells.size(), [&]() {
+        int sum = 0;
+        for (auto& c : cells) sum += nearestWanderer(c.first, c.second);
+        Bench::doNotOptimize(sum);
+    });
+    Bench::run("kutulu/think", 1, [&]() {
+        std::string command = think(entities);
+        Bench::doNotOptimize(command[0]);
+    });
+    return 0;
+}
@@ -0,0 +1,197 @@
+// Legends of Code and Magicのベンチマーク
+#define main locm_main
+#include "../Legends_of_Code_and_Magic/main.cc"
+#undef main
+
+#include <sstream>
+#include "bench.h"
+#include "locm_nodes.h"
+
+// 対戦フェーズの典型的な1ターン分の入力 (手札8枚 + 盤面6枚)
+const char BATTLE_TURN[] =
+    "23 7 18 15 1\n"
+    "19 7 17 10 0\n"
+    "5\n"
+    "14\n"
+    "12 3 0 0 2 2 2 ------ 0 0 0\n"
+    "25 9 0 0 2 3 1 ------ 0 0 0\n"
+    "37 13 0 0 6 5 7 ---G-- 0 0 0\n"
+    "51 17 0 0 4 3 5 ----L- 0 0 0\n"
+    "69 21 0 0 3 4 4 B----- 0 0 0\n"
+    "118 25 0 1 0 0 3 -----W 0 0 0\n"
+    "141 27 0 2 0 -1 -1 ------ 0 0 0\n"
+    "151 29 0 3 5 0 0 ------ 0 -3 1\n"
+    "48 1 1 0 1 2 1 ------ 0 0 0\n"
+    "86 5 1 0 3 1 5 -C---- 0 0 0\n"
+    "96 11 1 0 4 3 2 BCDG-- 0 0 0\n"
+    "28 8 -1 0 2 1 2 ------ 0 0 0\n"
+    "53 12 -1 0 4 1 1 ---GL- 0 0 0\n"
+    "100 20 -1 0 3 3 4 ---G-W 0 0 0\n";
+
+// 以前のcin >>による読み込みと同じことをistringstreamで行う (比較用)
+Card inputCardByStream(istream& in)
+{
+    int number, id, location, type, cost, attack, defense, myHealthChange, opponentHealthChange, cardDraw;
+    string abilities;
+    in >> number >> id >> location >> type >> cost >> attack >> defense
+       >> abilities >> myHealthChange >> opponentHealthChange >> cardDraw;
+    return Card(number, id, location, type, cost, attack, defense,
+                Card::parseAbilities(abilities.c_str()), myHealthChange, opponentHealthChange, cardDraw);
+}
+
+GameNode inputNodeByStream(istream& in)
+{
+    int myHealth, myMana, myDeck, myRune, opHealth, opMana, opDeck, opRune, opponentHand, cardCount;
+    in >> myHealth >> myMana >> myDeck >> myRune >> opHealth >> opMana >> opDeck >> opRune;
+    in >> opponentHand >> cardCount;
+
+    FixedVector<Card, GC::MAX_CARDS> cards;
+    for (int i = 0; i < min(cardCount, GC::MAX_CARDS); i++)
+    {
+        cards.push_back(inputCardByStream(in));
+    }
+    return GameNode(myHealth, myMana, myDeck, myRune,
+                    opHealth, opMana, opDeck, opRune, opponentHand, cards);
+}
+
+void benchParse()
+{
+    const int TURNS = 10000;
+
+    Bench::run("locm/parse turn (Reader)", TURNS, [&]() {
+        for (int i = 0; i < TURNS; i++)
+        {
+            reader.load(BATTLE_TURN, sizeof(BATTLE_TURN) - 1);
+            GameNode node = GameNode::input();
+            Bench::doNotOptimize(node.hash);
+        }
+    });
+    Bench::run("locm/parse turn (istringstream)", TURNS, [&]() {
+        for (int i = 0; i < TURNS; i++)
+        {
+            istringstream in(BATTLE_TURN);
+            GameNode node = inputNodeByStream(in);
+            Bench::doNotOptimize(node.hash);
+        }
+    });
+}
+
+void benchGameNode()
+{
+    auto nodes = makeBattleNodes(64);
+
+    // 全局面の合法な攻撃・召喚を、make/unmakeで1回ずつ試す
+    vector<pair<int, Move>> attacks, summons;
+    for (int n = 0; n < (int)nodes.size(); n++)
+    {
+        FixedVector<Move, MAX_ACTIONS> actions;
+        nodes[n].legalActions(actions);
+        for (const Move& action : actions)
+        {
+            if (action.type == GC::ATTACK) attacks.emplace_back(n, action);
+            if (action.type == GC::SUMMON) summons.emplace_back(n, action);
+        }
+    }
+
+    Bench::run("locm/GameNode::attack + unmake", attacks.size(), [&]() {
+        for (auto& a : attacks)
+        {
+            GameNode& node = nodes[a.first];
+            Undo undo;
+            node.attack(a.second.target1, a.second.target2, &undo);
+            Bench::doNotOptimize(node.hash);
+            node.unmake(undo);
+        }
+    });
+    Bench::run("locm/GameNode::summon + unmake", summons.size(), [&]() {
+        for (auto& a : summons)
+        {
+            GameNode& node = nodes[a.first];
+            Undo undo;
+            node.summon(a.second.target1, &undo);
+            Bench::doNotOptimize(node.hash);
+            node.unmake(undo);
+        }
+    });
+
+    vector<Card> creatures;
+    for (auto& node : nodes) for (auto& card : node.cards) creatures.push_back(card);
+    Bench::run("locm/evaluateCreature", creatures.size(), [&]() {
+        int sum = 0;
+        for (auto& card : creatures) sum += evaluateCreature(card);
+        Bench::doNotOptimize(sum);
+    });
+}
+
+// 時間制限を外したbattle()。ビームサーチは全探索できるかhistoryが一杯になるまで続く
+void benchBattle()
+{
+    auto nodes = makeBattleNodes(8);
+    timeManager = TimeManager(3600LL * 1000 * 1000, 3600LL * 1000 * 1000);
+
+    Bench::run("locm/battle (no time limit)", nodes.size(), [&]() {
+        for (auto& node : nodes)
+        {
+            GameNode copy = node;
+            timeManager.startTurn(Timer(), true);
+            Strategy strategy = battle(copy);
+            Bench::doNotOptimize(strategy.size());
+        }
+    });
+}
+
+// ドラフトのシミュレーションで使う対戦。デッキはカードテーブルから決まった乱数で選んだ16組で固定する
+void benchPlayout()
+{
+    const int DECKS = 16;
+    const int GAMES = 1000;
+    const int poolSize = sizeof(CardDB::cards) / sizeof(CardDB::cards[0]);
+
+    mt19937 mt(30);
+    static const CardDB::Data* decks[DECKS][Playout::DECK_SIZE];
+    for (int d = 0; d < DECKS; d++)
+    {
+        for (int i = 0; i < Playout::DECK_SIZE; i++) decks[d][i] = &CardDB::cards[mt() % poolSize];
+    }
+
+    Random::setSeed(1);
+    Bench::run("locm/Playout::play", GAMES, [&]() {
+        double wins = 0;
+        for (int i = 0; i < GAMES; i++)
+        {
+            wins += Playout::play(decks[i % DECKS], decks[(i + 1) % DECKS], i % 2 == 0);
+        }
+        Bench::doNotOptimize(wins);
+    });
+}
+
+// 以前の乱数 (mt19937 + 剰余) との比較
+void benchRandom()
+{
+    const int DRAWS = 1000000;
+
+    mt19937 mt(Random::seed);
+    Bench::run("random/mt19937 % n", DRAWS, [&]() {
+        unsigned sum = 0;
+        for (int i = 0; i < DRAWS; i++) sum += mt() % (i % 100 + 1);
+        Bench::doNotOptimize(sum);
+    });
+    Bench::run("random/PCG32 bounded (Random::randInt)", DRAWS, [&]() {
+        unsigned sum = 0;
+        for (int i = 0; i < DRAWS; i++) sum += Random::randInt(i % 100 + 1);
+        Bench::doNotOptimize(sum);
+    });
+}
+
+int main()
+{
+    Zobrist::init();
+
+    Bench::header();
+    benchParse();
+    benchRandom();
+    benchGameNode();
+    benchPlayout();
+    benchBattle();
+    return 0;
+}
@@ -0,0 +1,117 @@
+// Amadeus Challengeの検査: 自分・相手の行動をランダムにapplyしていき、差分更新したmyLead・otherLead・
+// 惑星ごとの寄与・totalが、initEvaluationで一から計算し直したものと一致することを確かめる。
+// 最後にundoで全て戻すと、局面が元通りになることも確かめる。
+// resolveTurnについては、コピーに適用して評価した値と一致し、局面を元通りに戻すことを確かめる
+#define main amadeus_main
+#include "../Amadeus_Challenge/main.cc"
+#undef main
+
+#include "amadeus_states.h"
+
+bool sameMask(const PlanetMask& a, const PlanetMask& b) {
+    return a.bits[0] == b.bits[0] and a.bits[1] == b.bits[1];
+}
+
+bool sameEvaluation(const GameState& a, const GameState& b) {
+    if (!sameMask(a.myLead, b.myLead) or !sameMask(a.otherLead, b.otherLead) or a.total != b.total) return false;
+    for (int id = 0; id < planetCount; id++) {
+        if (a.contribution[id] != b.contribution[id]) return false;
+    }
+    return true;
+}
+
+bool sameState(const GameState& a, const GameState& b) {
+    return a.myUnits == b.myUnits and a.otherUnits == b.otherUnits and sameEvaluation(a, b);
+}
+
+bool evaluationIsFresh(const GameState& state) {
+    GameState fresh = state;
+    fresh.initEvaluation();
+    return sameEvaluation(state, fresh);
+}
+
+// resolveTurnと同じ順で、コピーした局面に両者の行動を適用して評価する
+int resolveByCopy(GameState state, const TurnPlan& mine, const TurnPlan& theirs) {
+    for (int i = 0; i < PLACEMENT_COUNT; i++) {
+        if (mine.targets[i] >= 0) state.apply(NORMAL, mine.targets[i]);
+        if (theirs.targets[i] >= 0) state.applyOther(NORMAL, theirs.targets[i]);
+    }
+    state.apply(UNIT_SPREAD, mine.spread);
+    state.applyOther(UNIT_SPREAD, theirs.spread);
+    return evaluateGameState(state);
+}
+
+struct Step {
+    bool mine;
+    int type;
+    int target;
+    StateUndo undo;
+};
+
+int main() {
+    const int SEQUENCES = 200;
+    const int LENGTH    = 2 * (PLACEMENT_COUNT + 1);
+
+    string constants = makeConstantsText();
+    reader.load(constants.data(), constants.size());
+    inputGameConstants();
+
+    mt19937 mt(1);
+    auto states = makeStates(64);
+
+    int checks = 0, failures = 0;
+    for (auto& state : states) {
+        for (int s = 0; s < SEQUENCES; s++) {
+            GameState original = state;
+            vector<Step> steps;
+
+            for (int depth = 0; depth < LENGTH; depth++) {
+                // 両者の配置と、5体以上いる惑星からのUNIT SPREADを混ぜる
+                Step step;
+                step.mine   = mt() % 2 == 0;
+                step.type   = NORMAL;
+                step.target = mt() % planetCount;
+                auto& units = step.mine ? state.myUnits : state.otherUnits;
+                if (mt() % 4 == 0 and units[step.target] >= 5) step.type = UNIT_SPREAD;
+
+                if (step.mine) state.apply(step.type, step.target, &step.undo);
+                else state.applyOther(step.type, step.target, &step.undo);
+                steps.push_back(step);
+
+                checks++;
+                if (!evaluationIsFresh(state)) failures++;
+            }
+            while (!steps.empty()) {
+                Step& step = steps.back();
+                if (step.mine) state.undo(step.type, step.target, step.undo);
+                else state.undoOther(step.type, step.target, step.undo);
+                steps.pop_back();
+            }
+            checks++;
+            if (!sameState(state, original)) failures++;
+        }
+    }
+
+    printf("amadeus apply/undo: %d checks, %d failures\n", checks, failures);
+
+    int turnChecks = 0, turnFailures = 0;
+    OpponentModel opponent;
+    for (auto& state : states) {
+        opponent.prepare(state);
+        for (int s = 0; s < SEQUENCES; s++) {
+            // 自分の行動は5体以上いる惑星からのunit spreadを混ぜた一様な乱択、相手の行動はOpponentModelで作る
+            TurnPlan mine, theirs = opponent.sample(state, s == 0);
+            for (int i = 0; i < PLACEMENT_COUNT; i++) mine.targets[i] = mt() % 2 ? (int)(mt() % planetCount) : -1;
+            mine.spread = mt() % planetCount;
+            if (state.myUnits[mine.spread] < 5) mine.spread = -1;
+
+            GameState original = state;
+            int expected = resolveByCopy(state, mine, theirs);
+            turnChecks++;
+            if (resolveTurn(state, mine, theirs) != expected or !sameState(state, original)) turnFailures++;
+        }
+    }
+
+    printf("amadeus resolveTurn: %d checks, %d failures\n", turnChecks, turnFailures);
+    return failures == 0 and turnFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// Code of Kutuluの検査: ランダムな迷路とランダムな始点の集合について、bitboardの幅優先探索
+// (distanceLayers, withinSteps, reachable) の結果が、距離表から求めた最短距離と一致することを確かめる。
+// また、飛び込む直前のSlasherが標的のマスに留まったExplorerにだけ当たることを確かめる
+#define main kutulu_main
+#include "../Code_of_Kutulu/main.cc"
+#undef main
+
+#include "kutulu_input.h"
+#include "kutulu_bitboard.h"
+
+// 壁が3割ほどのランダムな迷路のゲーム定数を作る
+string makeMazeText(mt19937& mt) {
+    int w = 3 + mt() % (MAX_WIDTH - 2),
+        h = 3 + mt() % (MAX_HEIGHT - 2);
+    string text = to_string(w) + "\n" + to_string(h) + "\n";
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int r = mt() % 100;
+            text += r < 30 ? '#' : r < 32 ? 'w' : '.';
+        }
+        text += "\n";
+    }
+    return text + "3 1 3 40\n";
+}
+
+// (3, 1)の自分を、(6, 1)からRUSHINGで狙うSlasher (param2が標的のid) と、離れた所にいるもう1人のExplorer。
+// 自分がactionで1ターン進めたときに、Slasherに当たったかを返す
+bool rushHits(const Action& action) {
+    vector<Entity> entities = {
+        Entity(TYPE_EXPLORER, 0, 3, 1, 200, 2, 3),
+        Entity(TYPE_EXPLORER, 1, 17, 13, 200, 2, 3),
+        Entity(TYPE_SLASHER, 5, 6, 1, 0, STATE_RUSHING, 0),
+    };
+    Node node(entities, 0, 0);
+    Simulator(&node).step(action);
+    return node.explorers[0].sanity == 200 - HIT_DAMAGE - sanityLossLonely;
+}
+
+int main() {
+    const int MAZES   = 200;
+    const int SOURCES = 50;
+
+    mt19937 mt(1);
+    static BitBoard layers[MAX_CELLS];
+    static int layerOf[MAX_WIDTH][MAX_HEIGHT];
+
+    int checks = 0, failures = 0;
+    for (int m = 0; m < MAZES; m++) {
+        string text = makeMazeText(mt);
+        memset(maze, 0, sizeof(maze));
+        reader.load(text.data(), text.size());
+        inputGameConstant();
+        buildMazeBoards();
+        if (cellCount == 0) continue;
+
+        for (int s = 0; s < SOURCES; s++) {
+            // 1~3個の始点 (壁でないマス)
+            BitBoard from;
+            int sources[3], sourceCount = 1 + mt() % 3;
+            for (int i = 0; i < sourceCount; i++) {
+                sources[i] = mt() % cellCount;
+                from.set(cellX[sources[i]], cellY[sources[i]]);
+            }
+
+            // 各マスが何層目に入ったか。2つの層に入ったら失敗
+            bool overlapped = false;
+            for (auto& column : layerOf) fill(begin(column), end(column), -1);
+            int layerCount = distanceLayers(from, layers, MAX_CELLS);
+            for (int d = 0; d < layerCount; d++) {
+                layers[d].forEach([&](int x, int y) {
+                    if (layerOf[x][y] >= 0) overlapped = true;
+                    layerOf[x][y] = d;
+                });
+            }
+            checks++;
+            if (overlapped) failures++;
+
+            int k = mt() % 12;
+            BitBoard near = withinSteps(from, k),
+                     all  = reachable(from);
+            for (int x = 0; x < width; x++) {
+                for (int y = 0; y < height; y++) {
+                    int c = cellIndex[x][y];
+                    int expected = UNREACHABLE;
+                    for (int i = 0; c >= 0 and i < sourceCount; i++) {
+                        expected = min<int>(expected, distanceTable[sources[i] * cellCount + c]);
+                    }
+                    // 距離表は254より遠い組を254で止めているので、その先は比べない
+                    if (expected == UNREACHABLE - 1) continue;
+
+                    checks++;
+                    bool ok = (expected == UNREACHABLE) ? layerOf[x][y] < 0 : layerOf[x][y] == expected;
+                    ok = ok and near.test(x, y) == (expected <= k) and all.test(x, y) == (expected != UNREACHABLE);
+                    if (!ok) failures++;
+                }
+            }
+        }
+    }
+
+    printf("kutulu bitboard BFS: %d checks, %d failures\n", checks, failures);
+
+    memset(maze, 0, sizeof(maze));
+    reader.load(CONSTANTS, sizeof(CONSTANTS) - 1);
+    inputGameConstant();
+    bool waitHit = rushHits(Action(ACTION_WAIT)),
+         moveHit = rushHits(Action(ACTION_MOVE, 2, 1));
+    bool rushOk = waitHit and !moveHit;
+    printf("kutulu slasher rush: %s (wait: %s, move: %s)\n", rushOk ? "ok" : "FAILED",
+           waitHit ? "hit" : "missed", moveHit ? "hit" : "missed");
+    return failures == 0 and rushOk ? 0 : 1;
+}
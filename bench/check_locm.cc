@@ -0,0 +1,85 @@
+// Legends of Code and Magicの検査: ランダムな行動列をapplyしてからunmakeで戻すと、
+// 差分更新したハッシュが計算し直したものと一致し、局面が元通りになることを確かめる
+#define main locm_main
+#include "../Legends_of_Code_and_Magic/main.cc"
+#undef main
+
+#include "locm_nodes.h"
+
+bool sameCard(const Card& a, const Card& b)
+{
+    return a.number == b.number and a.id == b.id and a.location == b.location and a.type == b.type and
+           a.cost == b.cost and a.abilities == b.abilities and a.attack == b.attack and a.defense == b.defense and
+           a.myHealthChange == b.myHealthChange and a.opponentHealthChange == b.opponentHealthChange and
+           a.cardDraw == b.cardDraw and a.canUse == b.canUse;
+}
+
+bool sameNode(const GameNode& a, const GameNode& b)
+{
+    if (a.myHealth != b.myHealth or a.myMana != b.myMana or a.opHealth != b.opHealth or a.hash != b.hash) return false;
+    if (a.cards.size() != b.cards.size()) return false;
+    for (int i = 0; i < a.cards.size(); i++)
+    {
+        if (!sameCard(a.cards[i], b.cards[i])) return false;
+    }
+    return true;
+}
+
+bool hashIsFresh(const GameNode& node)
+{
+    GameNode copy = node;
+    copy.computeHash();
+    return copy.hash == node.hash;
+}
+
+int main()
+{
+    const int SEQUENCES = 200;
+    mt19937 mt(1);
+    auto nodes = makeBattleNodes(256);
+    for (auto& node : nodes) node.computeHash();
+
+    int checks = 0, failures = 0;
+    FixedVector<Move, MAX_ACTIONS> actions;
+    for (auto& node : nodes)
+    {
+        for (int s = 0; s < SEQUENCES; s++)
+        {
+            GameNode original = node;
+            vector<Undo> undos;
+
+            for (int depth = 0; depth < MAX_SEARCH_DEPTH; depth++)
+            {
+                // 合法手に加えて、失敗するはずの行動も混ぜる
+                Move action;
+                node.legalActions(actions);
+                if (actions.size() == 0 or mt() % 4 == 0)
+                {
+                    int n = node.cards.size();
+                    action = Move(GC::ATTACK, mt() % n, (int)(mt() % (n + 1)) - 1);
+                }
+                else
+                {
+                    action = actions[mt() % actions.size()];
+                }
+
+                Undo undo;
+                if (node.apply(action, &undo)) undos.push_back(undo);
+                else node.unmake(undo);     // 失敗したときのunmakeは何もしない
+
+                checks++;
+                if (!hashIsFresh(node)) failures++;
+            }
+            while (!undos.empty())
+            {
+                node.unmake(undos.back());
+                undos.pop_back();
+            }
+            checks++;
+            if (!sameNode(node, original)) failures++;
+        }
+    }
+
+    printf("locm make/unmake: %d checks, %d failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
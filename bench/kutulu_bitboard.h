@@ -0,0 +1,191 @@
+// Code of Kutuluの迷路のbitboardと、それを使う幅優先探索 (main.ccの後にincludeする)。
+// 盤面のマスの集合を、y * MAX_WIDTH + x番目のbitで表す (24x20 = 480マスなので64bit 8個に収まる)。
+// 幅優先探索は、1層ごとに集合全体を上下左右にシフトして壁を除くだけで進められる。
+// -mavx2でコンパイルしたときはAVX2で256bitずつ処理し、そうでなければ64bitずつ処理する。
+// ボットは1ターン目に作る距離表を引くだけなので、ここではベンチマークと検査で距離表と比べるためだけに使う。
+#pragma once
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+const int BOARD_WORDS = (MAX_WIDTH * MAX_HEIGHT + 63) / 64;
+
+struct BitBoard {
+    alignas(32) uint64_t w[BOARD_WORDS];
+
+    BitBoard() { memset(w, 0, sizeof(w)); }
+
+    static int bit(int x, int y) { return y * MAX_WIDTH + x; }
+
+    void set(int x, int y)        { w[bit(x, y) >> 6] |= 1ULL << (bit(x, y) & 63); }
+    void reset(int x, int y)      { w[bit(x, y) >> 6] &= ~(1ULL << (bit(x, y) & 63)); }
+    bool test(int x, int y) const { return w[bit(x, y) >> 6] >> (bit(x, y) & 63) & 1; }
+
+    bool any() const {
+        uint64_t r = 0;
+        for (int i = 0; i < BOARD_WORDS; i++) r |= w[i];
+        return r != 0;
+    }
+    int count() const {
+        int r = 0;
+        for (int i = 0; i < BOARD_WORDS; i++) r += __builtin_popcountll(w[i]);
+        return r;
+    }
+    bool operator==(const BitBoard& b) const {
+        return memcmp(w, b.w, sizeof(w)) == 0;
+    }
+    bool operator!=(const BitBoard& b) const {
+        return !(*this == b);
+    }
+
+    // 含まれるマスごとにf(x, y)を呼ぶ
+    template<class F>
+    void forEach(F f) const {
+        for (int i = 0; i < BOARD_WORDS; i++) {
+            for (uint64_t bits = w[i]; bits != 0; bits &= bits - 1) {
+                int b = i * 64 + __builtin_ctzll(bits);
+                f(b % MAX_WIDTH, b / MAX_WIDTH);
+            }
+        }
+    }
+
+#ifdef __AVX2__
+    static_assert(BOARD_WORDS == 8, "BitBoard assumes two 256-bit lanes");
+
+    __m256i lane(int i) const { return _mm256_load_si256((const __m256i*)w + i); }
+    void setLane(int i, __m256i v) { _mm256_store_si256((__m256i*)w + i, v); }
+
+    BitBoard operator&(const BitBoard& b) const {
+        BitBoard r;
+        for (int i = 0; i < 2; i++) r.setLane(i, _mm256_and_si256(lane(i), b.lane(i)));
+        return r;
+    }
+    BitBoard operator|(const BitBoard& b) const {
+        BitBoard r;
+        for (int i = 0; i < 2; i++) r.setLane(i, _mm256_or_si256(lane(i), b.lane(i)));
+        return r;
+    }
+    // this & ~b
+    BitBoard andNot(const BitBoard& b) const {
+        BitBoard r;
+        for (int i = 0; i < 2; i++) r.setLane(i, _mm256_andnot_si256(b.lane(i), lane(i)));
+        return r;
+    }
+
+    // 全てのbitをs (1 <= s < 64) だけ上位へずらす。各64bitの下位には1つ下の64bitからあふれた分が入る
+    BitBoard shiftUp(int s) const {
+        __m256i v0 = lane(0), v1 = lane(1),
+                p0 = _mm256_permute4x64_epi64(v0, _MM_SHUFFLE(2, 1, 0, 3)),    // w3 w0 w1 w2
+                p1 = _mm256_permute4x64_epi64(v1, _MM_SHUFFLE(2, 1, 0, 3)),    // w7 w4 w5 w6
+                c0 = _mm256_blend_epi32(p0, _mm256_setzero_si256(), 0x03),     // 0  w0 w1 w2
+                c1 = _mm256_blend_epi32(p1, p0, 0x03);                         // w3 w4 w5 w6
+        __m128i left = _mm_cvtsi32_si128(s), right = _mm_cvtsi32_si128(64 - s);
+        BitBoard r;
+        r.setLane(0, _mm256_or_si256(_mm256_sll_epi64(v0, left), _mm256_srl_epi64(c0, right)));
+        r.setLane(1, _mm256_or_si256(_mm256_sll_epi64(v1, left), _mm256_srl_epi64(c1, right)));
+        return r;
+    }
+    // 全てのbitをs (1 <= s < 64) だけ下位へずらす
+    BitBoard shiftDown(int s) const {
+        __m256i v0 = lane(0), v1 = lane(1),
+                p0 = _mm256_permute4x64_epi64(v0, _MM_SHUFFLE(0, 3, 2, 1)),    // w1 w2 w3 w0
+                p1 = _mm256_permute4x64_epi64(v1, _MM_SHUFFLE(0, 3, 2, 1)),    // w5 w6 w7 w4
+                c0 = _mm256_blend_epi32(p0, p1, 0xC0),                         // w1 w2 w3 w4
+                c1 = _mm256_blend_epi32(p1, _mm256_setzero_si256(), 0xC0);     // w5 w6 w7 0
+        __m128i right = _mm_cvtsi32_si128(s), left = _mm_cvtsi32_si128(64 - s);
+        BitBoard r;
+        r.setLane(0, _mm256_or_si256(_mm256_srl_epi64(v0, right), _mm256_sll_epi64(c0, left)));
+        r.setLane(1, _mm256_or_si256(_mm256_srl_epi64(v1, right), _mm256_sll_epi64(c1, left)));
+        return r;
+    }
+#else
+    BitBoard operator&(const BitBoard& b) const {
+        BitBoard r;
+        for (int i = 0; i < BOARD_WORDS; i++) r.w[i] = w[i] & b.w[i];
+        return r;
+    }
+    BitBoard operator|(const BitBoard& b) const {
+        BitBoard r;
+        for (int i = 0; i < BOARD_WORDS; i++) r.w[i] = w[i] | b.w[i];
+        return r;
+    }
+    // this & ~b
+    BitBoard andNot(const BitBoard& b) const {
+        BitBoard r;
+        for (int i = 0; i < BOARD_WORDS; i++) r.w[i] = w[i] & ~b.w[i];
+        return r;
+    }
+
+    // 全てのbitをs (1 <= s < 64) だけ上位へずらす。各64bitの下位には1つ下の64bitからあふれた分が入る
+    BitBoard shiftUp(int s) const {
+        BitBoard r;
+        r.w[0] = w[0] << s;
+        for (int i = 1; i < BOARD_WORDS; i++) r.w[i] = (w[i] << s) | (w[i - 1] >> (64 - s));
+        return r;
+    }
+    // 全てのbitをs (1 <= s < 64) だけ下位へずらす
+    BitBoard shiftDown(int s) const {
+        BitBoard r;
+        for (int i = 0; i + 1 < BOARD_WORDS; i++) r.w[i] = (w[i] >> s) | (w[i + 1] << (64 - s));
+        r.w[BOARD_WORDS - 1] = w[BOARD_WORDS - 1] >> s;
+        return r;
+    }
+#endif
+
+    BitBoard& operator&=(const BitBoard& b) { return *this = *this & b; }
+    BitBoard& operator|=(const BitBoard& b) { return *this = *this | b; }
+};
+
+// 迷路について不変の集合。buildMazeBoardsで作る
+BitBoard walkableBoard;
+BitBoard firstColumn, lastColumn;   // x = 0, x = MAX_WIDTH - 1の列
+
+// 各マスから上下左右に1歩動いたマスの集合 (壁は除かない)
+BitBoard neighbors(const BitBoard& b) {
+    return b.shiftUp(1).andNot(firstColumn) | b.shiftDown(1).andNot(lastColumn) |
+           b.shiftUp(MAX_WIDTH) | b.shiftDown(MAX_WIDTH);
+}
+
+// fromから壁を通らずにk歩以内で行けるマス
+BitBoard withinSteps(const BitBoard& from, int k) {
+    BitBoard cur = from & walkableBoard;
+    for (int i = 0; i < k; i++) {
+        BitBoard next = (cur | neighbors(cur)) & walkableBoard;
+        if (next == cur) break;
+        cur = next;
+    }
+    return cur;
+}
+
+// fromから壁を通らずに行けるマス
+BitBoard reachable(const BitBoard& from) {
+    return withinSteps(from, MAX_WIDTH * MAX_HEIGHT);
+}
+
+// fromからの距離ごとのマスの集合。layers[d]に距離がちょうどdのマスを入れ、層の数を返す
+// (maxLayers層で打ち切る)
+int distanceLayers(const BitBoard& from, BitBoard* layers, int maxLayers) {
+    BitBoard visited = from & walkableBoard;
+    int count = 0;
+    for (BitBoard frontier = visited; frontier.any() and count < maxLayers; count++) {
+        layers[count] = frontier;
+        frontier = (neighbors(frontier) & walkableBoard).andNot(visited);
+        visited |= frontier;
+    }
+    return count;
+}
+
+// inputGameConstantで読んだmazeから、通れるマスのbitboardを作る
+void buildMazeBoards() {
+    walkableBoard = firstColumn = lastColumn = BitBoard();
+    for (int y = 0; y < MAX_HEIGHT; y++) {
+        firstColumn.set(0, y);
+        lastColumn.set(MAX_WIDTH - 1, y);
+    }
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            if (!(maze[x][y] & WALL)) walkableBoard.set(x, y);
+        }
+    }
+}
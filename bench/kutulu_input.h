@@ -0,0 +1,39 @@
+// Code of Kutuluのベンチマークで使う入力 (19x15の迷路と1ターン分のentity)
+#pragma once
+
+const char CONSTANTS[] =
+    "19\n"
+    "15\n"
+    "###################\n"
+    "#w................#\n"
+    "#.#.#.#.#.#.#.#.#.#\n"
+    "#.................#\n"
+    "#.#.#.#.#.#.#.#.#.#\n"
+    "#.................#\n"
+    "#.#.#.#.#.#.#.#.#.#\n"
+    "#.................#\n"
+    "#.#.#.#.#.#.#.#.#.#\n"
+    "#.................#\n"
+    "#.#.#.#.#.#.#.#.#.#\n"
+    "#.................#\n"
+    "#.#.#.#.#.#.#.#.#.#\n"
+    "#................w#\n"
+    "###################\n"
+    "3 1 3 40\n";
+
+// 探索者4人・Wanderer6体・Slasher1体・エフェクト2個の1ターン分の入力
+const char TURN[] =
+    "13\n"
+    "EXPLORER 0 9 3 195 2 3\n"
+    "EXPLORER 1 17 1 115 2 3\n"
+    "EXPLORER 2 5 3 176 2 3\n"
+    "EXPLORER 3 12 9 170 2 3\n"
+    "WANDERER 10 2 5 6 1 -1\n"
+    "WANDERER 11 8 1 24 1 -1\n"
+    "WANDERER 12 17 12 0 1 -1\n"
+    "WANDERER 13 17 5 14 0 -1\n"
+    "WANDERER 14 4 7 1 0 -1\n"
+    "WANDERER 15 7 1 34 0 -1\n"
+    "SLASHER 30 4 5 3 0 -1\n"
+    "EFFECT_PLAN 40 9 3 4 0 -1\n"
+    "EFFECT_LIGHT 41 5 3 2 2 -1\n";
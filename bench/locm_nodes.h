@@ -0,0 +1,33 @@
+// Legends of Code and Magicのベンチマーク・検査で使う局面 (main.ccの後にincludeする)
+#pragma once
+
+// 決まった乱数で対戦フェーズの局面を作る。
+// 手札と両者の場のCreatureをカードテーブルから選び、体力とマナもばらつかせる
+vector<GameNode> makeBattleNodes(int count)
+{
+    mt19937 mt(20180828);
+    const int poolSize = sizeof(CardDB::cards) / sizeof(CardDB::cards[0]);
+
+    vector<GameNode> nodes;
+    for (int n = 0; n < count; n++)
+    {
+        FixedVector<Card, GC::MAX_CARDS> cards;
+        int id = 1;
+        auto addCards = [&](int location, int num)
+        {
+            for (int i = 0; i < num; i++)
+            {
+                const CardDB::Data& d = CardDB::cards[mt() % poolSize];
+                cards.push_back(Card(d.number, id++, location, d.type, d.cost, d.attack, d.defense,
+                                     d.abilities, d.myHealthChange, d.opponentHealthChange, d.cardDraw));
+            }
+        };
+        addCards(GC::MY_HAND, 4 + mt() % 5);
+        addCards(GC::MY_SIDE, 2 + mt() % 5);
+        addCards(GC::OP_SIDE, 2 + mt() % 5);
+
+        nodes.push_back(GameNode(5 + mt() % 26, 3 + mt() % 10, 15, 25,
+                                 5 + mt() % 26, 3 + mt() % 10, 15, 25, 5, cards));
+    }
+    return nodes;
+}